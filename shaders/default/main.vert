@@ -0,0 +1,28 @@
+#version 450
+
+layout(location = 0) in vec2  position;
+layout(location = 1) in vec3  color;
+layout(location = 2) in vec2  instance_offset;
+layout(location = 3) in float instance_scale;
+layout(location = 4) in vec3  instance_color;
+
+layout(push_constant) uniform draw_constants {
+    vec2  offset;
+    float scale;
+} draw;
+
+layout(set = 0, binding = 0) uniform frame_uniforms {
+    float time;
+    float angle;
+} frame;
+
+layout(location = 0) out vec3 frag_color;
+
+void main() {
+    float c      = cos(frame.angle);
+    float s      = sin(frame.angle);
+    vec2  turned = mat2(c, s, -s, c) * position;
+    vec2  placed = turned * instance_scale + instance_offset;
+    gl_Position = vec4(placed * draw.scale + draw.offset, 0.0, 1.0);
+    frag_color  = color * instance_color;
+}
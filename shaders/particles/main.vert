@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 velocity;
+
+layout(location = 0) out vec3 frag_color;
+
+void main() {
+    gl_Position  = vec4(position, 0.0, 1.0);
+    gl_PointSize = 1.0;
+    float speed  = clamp(length(velocity), 0.0, 1.0);
+    frag_color   = mix(vec3(0.2, 0.4, 1.0), vec3(1.0, 0.6, 0.2), speed);
+}
@@ -0,0 +1,421 @@
+#include "allocator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+static std::uint64_t
+align_up(std::uint64_t t_value, std::uint64_t t_alignment)
+{
+	return t_alignment ? (t_value + t_alignment - 1) / t_alignment * t_alignment :
+                         t_value;
+}
+
+range_allocator::range_allocator(std::uint64_t t_size): m_size(t_size)
+{
+	if (m_size)
+		m_free.emplace(0, m_size);
+}
+
+std::optional<std::uint64_t>
+range_allocator::allocate(std::uint64_t t_size, std::uint64_t t_alignment)
+{
+	auto best       = m_free.end();
+	auto best_waste = std::numeric_limits<std::uint64_t>::max();
+	for (auto it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		auto const [offset, size] = *it;
+		auto const aligned        = align_up(offset, t_alignment);
+		if (aligned + t_size > offset + size)
+			continue;
+		if (auto const waste = size - t_size; waste < best_waste)
+		{
+			best       = it;
+			best_waste = waste;
+			if (!waste)
+				break;
+		}
+	}
+	if (best == m_free.end())
+		return std::nullopt;
+
+	auto const [offset, size] = *best;
+	auto const aligned        = align_up(offset, t_alignment);
+	m_free.erase(best);
+	// the padding in front and the tail stay free
+	if (aligned != offset)
+		m_free.emplace(offset, aligned - offset);
+	if (auto const end = aligned + t_size; end != offset + size)
+		m_free.emplace(end, offset + size - end);
+	m_used += t_size;
+	return aligned;
+}
+
+void
+range_allocator::free(std::uint64_t t_offset, std::uint64_t t_size)
+{
+	m_used -= t_size;
+	auto next = m_free.lower_bound(t_offset);
+	// merge with the following range
+	if (next != m_free.end() && t_offset + t_size == next->first)
+	{
+		t_size += next->second;
+		next = m_free.erase(next);
+	}
+	// merge with the preceding range
+	if (next != m_free.begin())
+	{
+		auto const prev = std::prev(next);
+		if (prev->first + prev->second == t_offset)
+		{
+			prev->second += t_size;
+			return;
+		}
+	}
+	m_free.emplace_hint(next, t_offset, t_size);
+}
+
+std::uint64_t
+range_allocator::size() const
+{
+	return m_size;
+}
+
+std::uint64_t
+range_allocator::used() const
+{
+	return m_used;
+}
+
+std::uint64_t
+range_allocator::largest_free() const
+{
+	std::uint64_t out = 0;
+	for (auto const & [offset, size] : m_free)
+		out = std::max(out, size);
+	return out;
+}
+
+std::size_t
+range_allocator::free_ranges() const
+{
+	return m_free.size();
+}
+
+allocation::allocation(allocation && t_other) noexcept
+{
+	*this = std::move(t_other);
+}
+
+allocation &
+allocation::operator=(allocation && t_other) noexcept
+{
+	if (this == &t_other)
+		return *this;
+	if (m_owner)
+		m_owner->release(*this);
+	m_owner         = std::exchange(t_other.m_owner, nullptr);
+	m_memory        = t_other.m_memory;
+	m_offset        = t_other.m_offset;
+	m_size          = t_other.m_size;
+	m_mapped        = t_other.m_mapped;
+	m_pool          = t_other.m_pool;
+	m_block         = t_other.m_block;
+	return *this;
+}
+
+allocation::~allocation()
+{
+	if (m_owner)
+		m_owner->release(*this);
+}
+
+vk::DeviceMemory
+allocation::memory() const
+{
+	return m_memory;
+}
+
+vk::DeviceSize
+allocation::offset() const
+{
+	return m_offset;
+}
+
+vk::DeviceSize
+allocation::size() const
+{
+	return m_size;
+}
+
+std::byte *
+allocation::mapped() const
+{
+	return m_mapped;
+}
+
+allocation::operator bool() const
+{
+	return m_owner;
+}
+
+device_allocator::device_allocator(
+    vk::PhysicalDevice const & t_phys,
+    vk::Device const &         t_dev,
+    vk::DeviceSize             t_block_size):
+	m_dev(t_dev),
+	m_props(t_phys.getMemoryProperties()),
+	m_pools(m_props.memoryTypeCount * 2)
+{
+	m_block_sizes.reserve(m_props.memoryTypeCount);
+	for (std::uint32_t i = 0; i < m_props.memoryTypeCount; ++i)
+	{
+		auto const heap = m_props.memoryHeaps[m_props.memoryTypes[i].heapIndex];
+		m_block_sizes.push_back(std::min(t_block_size, heap.size / 8));
+	}
+}
+
+std::uint32_t
+device_allocator::memory_type(
+    std::uint32_t           t_type_bits,
+    vk::MemoryPropertyFlags t_required,
+    vk::MemoryPropertyFlags t_preferred) const
+{
+	std::optional<std::uint32_t> fallback;
+	for (std::uint32_t i = 0; i < m_props.memoryTypeCount; ++i)
+	{
+		auto const flags = m_props.memoryTypes[i].propertyFlags;
+		if (!(t_type_bits & (1u << i)) || (flags & t_required) != t_required)
+			continue;
+		if ((flags & t_preferred) == t_preferred)
+			return i;
+		if (!fallback)
+			fallback = i;
+	}
+	if (!fallback)
+		throw std::runtime_error("no suitable memory type");
+	return *fallback;
+}
+
+allocation
+device_allocator::allocate(
+    vk::MemoryRequirements const & t_requirements,
+    resource_kind                  t_kind,
+    vk::MemoryPropertyFlags        t_required,
+    vk::MemoryPropertyFlags        t_preferred)
+{
+	auto const type =
+	    memory_type(t_requirements.memoryTypeBits, t_required, t_preferred);
+	auto const pool_index = type * 2 + static_cast<std::uint32_t>(t_kind);
+	auto const block_size = m_block_sizes[type];
+	auto const dedicated  = t_requirements.size > block_size / 2;
+
+	std::scoped_lock lock(m_mutex);
+	auto &           pool = m_pools[pool_index];
+
+	auto const make_allocation = [&](std::size_t t_block, std::uint64_t t_offset) {
+		auto & b = *pool[t_block];
+		++b.allocations;
+		allocation out;
+		out.m_owner  = this;
+		out.m_memory = *b.memory;
+		out.m_offset = t_offset;
+		out.m_size   = t_requirements.size;
+		out.m_mapped = b.mapped ? b.mapped + t_offset : nullptr;
+		out.m_pool   = pool_index;
+		out.m_block  = t_block;
+		return out;
+	};
+
+	if (!dedicated)
+		for (std::size_t i = 0; i < pool.size(); ++i)
+			if (pool[i] && !pool[i]->dedicated)
+				if (auto const offset = pool[i]->ranges.allocate(
+				        t_requirements.size, t_requirements.alignment))
+					return make_allocation(i, *offset);
+
+	// no room left, get a new block
+	auto const size = dedicated ? t_requirements.size : block_size;
+	auto memory     = m_dev.allocateMemoryUnique({
+        .allocationSize  = size,
+        .memoryTypeIndex = type,
+    });
+	std::byte * mapped = nullptr;
+	if (m_props.memoryTypes[type].propertyFlags &
+	    vk::MemoryPropertyFlagBits::eHostVisible)
+		mapped = static_cast<std::byte *>(m_dev.mapMemory(*memory, 0, size));
+	block b {
+	    .memory      = std::move(memory),
+	    .ranges      = range_allocator(size),
+	    .mapped      = mapped,
+	    .allocations = 0,
+	    .dedicated   = dedicated,
+	};
+	auto const offset = b.ranges.allocate(t_requirements.size, 1);
+	// reuse the slot of a released dedicated block, keeps indices stable
+	auto slot = std::find(pool.begin(), pool.end(), std::nullopt);
+	if (slot == pool.end())
+		slot = pool.emplace(pool.end());
+	*slot = std::move(b);
+	return make_allocation(
+	    static_cast<std::size_t>(slot - pool.begin()),
+	    *offset);
+}
+
+void
+device_allocator::release(allocation & t_alloc)
+{
+	std::scoped_lock lock(m_mutex);
+	auto &           slot = m_pools[t_alloc.m_pool][t_alloc.m_block];
+	slot->ranges.free(t_alloc.m_offset, t_alloc.m_size);
+	if (!--slot->allocations && slot->dedicated)
+		slot.reset();
+	t_alloc.m_owner = nullptr;
+}
+
+allocation
+device_allocator::bind(
+    vk::Buffer const &      t_buffer,
+    vk::MemoryPropertyFlags t_required,
+    vk::MemoryPropertyFlags t_preferred)
+{
+	auto out = allocate(
+	    m_dev.getBufferMemoryRequirements(t_buffer),
+	    resource_kind::linear,
+	    t_required,
+	    t_preferred);
+	m_dev.bindBufferMemory(t_buffer, out.memory(), out.offset());
+	return out;
+}
+
+allocation
+device_allocator::bind(
+    vk::Image const &       t_image,
+    vk::ImageTiling         t_tiling,
+    vk::MemoryPropertyFlags t_required,
+    vk::MemoryPropertyFlags t_preferred)
+{
+	auto out = allocate(
+	    m_dev.getImageMemoryRequirements(t_image),
+	    t_tiling == vk::ImageTiling::eLinear ? resource_kind::linear :
+                                               resource_kind::optimal,
+	    t_required,
+	    t_preferred);
+	m_dev.bindImageMemory(t_image, out.memory(), out.offset());
+	return out;
+}
+
+allocator_stats
+device_allocator::stats() const
+{
+	std::scoped_lock lock(m_mutex);
+	allocator_stats  out {};
+	vk::DeviceSize   free = 0;
+	for (auto const & pool : m_pools)
+		for (auto const & b : pool)
+		{
+			if (!b)
+				continue;
+			++out.blocks;
+			out.allocations += b->allocations;
+			out.reserved += b->ranges.size();
+			out.used += b->ranges.used();
+			out.largest_free = std::max(out.largest_free, b->ranges.largest_free());
+			out.free_ranges += b->ranges.free_ranges();
+			free += b->ranges.size() - b->ranges.used();
+		}
+	out.fragmentation = free ? 1.0 - static_cast<double>(out.largest_free) /
+	                                     static_cast<double>(free) :
+                               0.0;
+	return out;
+}
+
+void
+print_allocator_stats(std::ostream & t_out, allocator_stats const & t_stats)
+{
+	t_out << t_stats.allocations << " allocations in " << t_stats.blocks
+	      << " blocks, " << t_stats.used << " of " << t_stats.reserved
+	      << " bytes used, " << t_stats.free_ranges
+	      << " free ranges, largest " << t_stats.largest_free
+	      << ", fragmentation " << t_stats.fragmentation << '\n';
+}
+
+void
+benchmark_allocator(
+    vk::PhysicalDevice const & t_phys,
+    vk::Device const &         t_dev,
+    std::ostream &             t_out)
+{
+	using clock = std::chrono::steady_clock;
+	using us    = std::chrono::duration<double, std::micro>;
+	// stay well under maxMemoryAllocationCount (4096 on many drivers) so the
+	// raw path doesn't fail, the allocator itself wouldn't care
+	auto const count = std::min<std::uint32_t>(
+	    1024, t_phys.getProperties().limits.maxMemoryAllocationCount / 2);
+
+	// a probe buffer tells which memory types vertex buffers may live in
+	auto const probe = t_dev.createBufferUnique({
+	    .size        = 1,
+	    .usage       = vk::BufferUsageFlagBits::eVertexBuffer,
+	    .sharingMode = vk::SharingMode::eExclusive,
+	});
+	device_allocator sub(t_phys, t_dev);
+	auto const base = t_dev.getBufferMemoryRequirements(*probe);
+	auto const type = sub.memory_type(
+	    base.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	// the same pseudo random sizes between 256B and 1MiB for both paths
+	std::mt19937_64                              rng(42);
+	std::uniform_int_distribution<std::uint64_t> dist(256, 1 << 20);
+	std::vector<vk::MemoryRequirements>          requests(count);
+	for (auto & r : requests)
+		r = {
+		    .size           = dist(rng),
+		    .alignment      = std::max<vk::DeviceSize>(base.alignment, 256),
+		    .memoryTypeBits = 1u << type,
+		};
+
+	std::vector<vk::DeviceMemory> raw(count);
+	auto const raw_start = clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		raw[i] = t_dev.allocateMemory({
+		    .allocationSize  = requests[i].size,
+		    .memoryTypeIndex = type,
+		});
+	auto const raw_mid = clock::now();
+	for (auto const memory : raw)
+		t_dev.freeMemory(memory);
+	auto const raw_end = clock::now();
+
+	std::vector<allocation> subs(count);
+	auto const sub_start = clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		subs[i] = sub.allocate(
+		    requests[i],
+		    resource_kind::linear,
+		    vk::MemoryPropertyFlagBits::eDeviceLocal);
+	auto const sub_mid = clock::now();
+	// free every other allocation first to leave holes behind
+	for (std::size_t i = 0; i < count; i += 2)
+		subs[i] = {};
+	auto const holes = sub.stats();
+	for (auto & a : subs)
+		a = {};
+	auto const sub_end = clock::now();
+
+	auto const per = [&](auto t_duration) {
+		return us(t_duration).count() / count;
+	};
+	t_out << std::fixed << std::setprecision(3) << count
+	      << " allocations of 256B-1MiB, microseconds per call\n"
+	      << "  vkAllocateMemory  " << per(raw_mid - raw_start)
+	      << " alloc, " << per(raw_end - raw_mid) << " free\n"
+	      << "  device_allocator  " << per(sub_mid - sub_start)
+	      << " alloc, " << per(sub_end - sub_mid) << " free\n"
+	      << "  with every other allocation freed: ";
+	t_out.unsetf(std::ios::floatfield);
+	print_allocator_stats(t_out, holes);
+}
@@ -0,0 +1,182 @@
+#ifndef ALLOCATOR_HPP_INCLUDED
+#define ALLOCATOR_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+///
+///@brief best fit allocator of offset ranges, free ranges are kept sorted by
+/// offset so neighbours coalesce on free
+///
+class range_allocator{
+	std::map<std::uint64_t, std::uint64_t> m_free; // offset -> size
+	std::uint64_t                          m_size;
+	std::uint64_t                          m_used = 0;
+
+	public:
+	explicit range_allocator(std::uint64_t t_size);
+
+	///
+	///@return offset of the range, nullopt if no free range fits
+	///
+	std::optional<std::uint64_t>
+	allocate(std::uint64_t t_size, std::uint64_t t_alignment);
+	void free(std::uint64_t t_offset, std::uint64_t t_size);
+
+	std::uint64_t size() const;
+	std::uint64_t used() const;
+	std::uint64_t largest_free() const;
+	std::size_t   free_ranges() const;
+};
+
+class device_allocator;
+
+///
+///@brief a piece of a device memory block, handed back to the allocator
+/// when destroyed
+///
+class allocation{
+	friend class device_allocator;
+	device_allocator * m_owner  = nullptr;
+	vk::DeviceMemory   m_memory = {};
+	vk::DeviceSize     m_offset = 0;
+	vk::DeviceSize     m_size   = 0;
+	std::byte *        m_mapped = nullptr;
+	std::uint32_t      m_pool   = 0;
+	std::size_t        m_block  = 0;
+
+	public:
+	allocation() = default;
+	allocation(allocation && t_other) noexcept;
+	allocation & operator=(allocation && t_other) noexcept;
+	allocation(allocation const &) = delete;
+	allocation & operator=(allocation const &) = delete;
+	~allocation();
+
+	vk::DeviceMemory memory() const;
+	vk::DeviceSize   offset() const;
+	vk::DeviceSize   size() const;
+	///
+	///@return pointer to the start of the allocation if its memory is host
+	/// visible, blocks stay mapped for their whole life
+	///
+	std::byte * mapped() const;
+	explicit    operator bool() const;
+};
+
+///
+///@brief what's placed in the memory, buffers and optimally tiled images
+/// never share a block so bufferImageGranularity never has to be padded for
+///
+enum class resource_kind{
+	linear,
+	optimal,
+};
+
+struct allocator_stats{
+	std::size_t    blocks;
+	std::size_t    allocations;
+	vk::DeviceSize reserved; ///< bytes of device memory allocated
+	vk::DeviceSize used;     ///< bytes handed out to allocations
+	vk::DeviceSize largest_free;
+	std::size_t    free_ranges;
+	///
+	///@brief 1 - largest free range / all free bytes, 0 when every free byte
+	/// is in a single range
+	///
+	double fragmentation;
+};
+
+///
+///@brief sub-allocates buffers and images from large device memory blocks,
+/// one set of blocks per memory type and resource kind
+///
+/// Requests bigger than half a block get a dedicated block of their own,
+/// which is released as soon as it's empty.
+///
+class device_allocator{
+	friend class allocation;
+
+	struct block{
+		vk::UniqueDeviceMemory memory;
+		range_allocator        ranges;
+		std::byte *            mapped;
+		std::size_t            allocations;
+		bool                   dedicated;
+	};
+
+	vk::Device                         m_dev;
+	vk::PhysicalDeviceMemoryProperties m_props;
+	std::vector<vk::DeviceSize>        m_block_sizes; // per memory type
+	// index is memory type * 2 + resource kind
+	std::vector<std::vector<std::optional<block>>> m_pools;
+	mutable std::mutex                             m_mutex;
+
+	void release(allocation & t_alloc);
+
+	public:
+	///
+	///@param[in] t_block_size size of the blocks, smaller heaps get blocks
+	/// of an eighth of the heap
+	///
+	device_allocator(
+	    vk::PhysicalDevice const & t_phys,
+	    vk::Device const &         t_dev,
+	    vk::DeviceSize             t_block_size = 64 << 20);
+	device_allocator(device_allocator const &) = delete;
+	device_allocator & operator=(device_allocator const &) = delete;
+
+	///
+	///@brief picks the memory type with all the required flags, preferring
+	/// one that has the preferred ones as well
+	///
+	std::uint32_t memory_type(
+	    std::uint32_t           t_type_bits,
+	    vk::MemoryPropertyFlags t_required,
+	    vk::MemoryPropertyFlags t_preferred = {}) const;
+
+	allocation allocate(
+	    vk::MemoryRequirements const & t_requirements,
+	    resource_kind                  t_kind,
+	    vk::MemoryPropertyFlags        t_required,
+	    vk::MemoryPropertyFlags        t_preferred = {});
+
+	///
+	///@brief allocates memory for the buffer and binds it
+	///
+	allocation bind(
+	    vk::Buffer const &      t_buffer,
+	    vk::MemoryPropertyFlags t_required,
+	    vk::MemoryPropertyFlags t_preferred = {});
+
+	///
+	///@brief allocates memory for the image and binds it
+	///
+	allocation bind(
+	    vk::Image const &       t_image,
+	    vk::ImageTiling         t_tiling,
+	    vk::MemoryPropertyFlags t_required,
+	    vk::MemoryPropertyFlags t_preferred = {});
+
+	allocator_stats stats() const;
+};
+
+void print_allocator_stats(std::ostream & t_out, allocator_stats const & t_stats);
+
+///
+///@brief times a batch of allocations and frees through the allocator
+/// against the same batch done with vkAllocateMemory/vkFreeMemory
+///
+void benchmark_allocator(
+    vk::PhysicalDevice const & t_phys,
+    vk::Device const &         t_dev,
+    std::ostream &             t_out);
+
+#endif // ALLOCATOR_HPP_INCLUDED
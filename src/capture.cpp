@@ -0,0 +1,284 @@
+#include "capture.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+bool
+is_bgra(vk::Format t_format)
+{
+	return t_format == vk::Format::eB8G8R8A8Unorm || t_format == vk::Format::eB8G8R8A8Srgb;
+}
+
+bool
+is_rgba(vk::Format t_format)
+{
+	return t_format == vk::Format::eR8G8B8A8Unorm || t_format == vk::Format::eR8G8B8A8Srgb;
+}
+
+} // namespace
+
+std::optional<capture_format>
+parse_capture_format(std::string_view t_name)
+{
+	if (t_name == "ppm")
+		return capture_format::ppm;
+	if (t_name == "raw")
+		return capture_format::raw;
+	return std::nullopt;
+}
+
+frame_capture::frame_capture(
+    device_allocator &            t_alloc,
+    vk::Device const &            t_dev,
+    vk::Format                    t_format,
+    vk::Extent2D                  t_extent,
+    std::size_t                   t_depth,
+    std::filesystem::path const & t_directory,
+    capture_format                t_file_format)
+    : m_alloc(t_alloc)
+    , m_dev(t_dev)
+    , m_format(t_file_format)
+    , m_image_format(t_format)
+    , m_directory(t_directory)
+    , m_ring(new readback[std::max<std::size_t>(t_depth, 1)])
+    , m_depth(std::max<std::size_t>(t_depth, 1))
+{
+	if (!is_bgra(t_format) && !is_rgba(t_format))
+		throw std::runtime_error("can't capture " + vk::to_string(t_format) + " images");
+	std::filesystem::create_directories(m_directory);
+	for (std::size_t i = 0; i < m_depth; ++i)
+		allocate(m_ring[i], vk::DeviceSize {t_extent.width} * t_extent.height * 4);
+	m_thread = std::thread(&frame_capture::run, this);
+}
+
+frame_capture::~frame_capture()
+{
+	flush();
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+void
+frame_capture::allocate(readback & t_frame, vk::DeviceSize t_capacity)
+{
+	// the old memory goes back before the new is taken
+	t_frame.buffer.reset();
+	t_frame.memory = {};
+	t_frame.buffer = m_dev.createBufferUnique({
+	    .size        = t_capacity,
+	    .usage       = vk::BufferUsageFlagBits::eTransferDst,
+	    .sharingMode = vk::SharingMode::eExclusive,
+	});
+	// the writer reads every byte, uncached memory would crawl
+	t_frame.memory = m_alloc.bind(
+	    *t_frame.buffer,
+	    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+	    vk::MemoryPropertyFlagBits::eHostCached);
+	t_frame.capacity = t_capacity;
+}
+
+bool
+frame_capture::record(
+    vk::CommandBuffer const & t_cmd,
+    vk::Image const &         t_image,
+    vk::ImageLayout           t_layout,
+    vk::Extent2D              t_extent,
+    std::uint64_t             t_frame)
+{
+	auto & r = m_ring[m_next];
+	if (r.status.load(std::memory_order_acquire) != state::free) {
+		++m_dropped;
+		return false;
+	}
+	// a free buffer has retired and been written, nothing uses it anymore
+	auto const bytes = vk::DeviceSize {t_extent.width} * t_extent.height * 4;
+	if (bytes > r.capacity)
+		allocate(r, bytes);
+	r.status.store(state::copying, std::memory_order_relaxed);
+	r.frame  = t_frame;
+	r.extent = t_extent;
+	m_next   = (m_next + 1) % m_depth;
+
+	vk::ImageSubresourceRange const range {
+	    .aspectMask     = vk::ImageAspectFlagBits::eColor,
+	    .baseMipLevel   = 0,
+	    .levelCount     = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount     = 1,
+	};
+	// the image was last written by its render pass or by a blit
+	t_cmd.pipelineBarrier(
+	    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer,
+	    vk::PipelineStageFlagBits::eTransfer,
+	    {},
+	    nullptr,
+	    nullptr,
+	    vk::ImageMemoryBarrier {
+	        .srcAccessMask       = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eTransferWrite,
+	        .dstAccessMask       = vk::AccessFlagBits::eTransferRead,
+	        .oldLayout           = t_layout,
+	        .newLayout           = vk::ImageLayout::eTransferSrcOptimal,
+	        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .image               = t_image,
+	        .subresourceRange    = range,
+	    });
+	t_cmd.copyImageToBuffer(
+	    t_image,
+	    vk::ImageLayout::eTransferSrcOptimal,
+	    *r.buffer,
+	    vk::BufferImageCopy {
+	        .bufferOffset      = 0,
+	        .bufferRowLength   = 0,
+	        .bufferImageHeight = 0,
+	        .imageSubresource  = {
+	            .aspectMask     = vk::ImageAspectFlagBits::eColor,
+	            .mipLevel       = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount     = 1,
+	        },
+	        .imageOffset = {},
+	        .imageExtent = {.width = t_extent.width, .height = t_extent.height, .depth = 1},
+	    });
+	// the present or whatever comes next waits on its own semaphore, only
+	// the layout has to be put back
+	t_cmd.pipelineBarrier(
+	    vk::PipelineStageFlagBits::eTransfer,
+	    vk::PipelineStageFlagBits::eHost | vk::PipelineStageFlagBits::eBottomOfPipe,
+	    {},
+	    vk::MemoryBarrier {
+	        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+	        .dstAccessMask = vk::AccessFlagBits::eHostRead,
+	    },
+	    nullptr,
+	    vk::ImageMemoryBarrier {
+	        .srcAccessMask       = {},
+	        .dstAccessMask       = {},
+	        .oldLayout           = vk::ImageLayout::eTransferSrcOptimal,
+	        .newLayout           = t_layout,
+	        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .image               = t_image,
+	        .subresourceRange    = range,
+	    });
+	return true;
+}
+
+void
+frame_capture::finished_before(std::uint64_t t_frame)
+{
+	std::size_t handed = 0;
+	{
+		std::lock_guard lock(m_mutex);
+		// copies are recorded in ring order, so they retire in it as well
+		for (std::size_t i = 0; i < m_depth; ++i) {
+			auto & r = m_ring[m_retired];
+			if (r.status.load(std::memory_order_relaxed) != state::copying || r.frame >= t_frame)
+				break;
+			r.status.store(state::writing, std::memory_order_relaxed);
+			m_queue.push_back(m_retired);
+			m_retired = (m_retired + 1) % m_depth;
+			++handed;
+		}
+	}
+	if (handed)
+		m_wake.notify_one();
+}
+
+void
+frame_capture::flush()
+{
+	finished_before(std::numeric_limits<std::uint64_t>::max());
+	std::unique_lock lock(m_mutex);
+	m_idle.wait(lock, [&] {
+		for (std::size_t i = 0; i < m_depth; ++i)
+			if (m_ring[i].status.load(std::memory_order_acquire) == state::writing)
+				return false;
+		return true;
+	});
+}
+
+std::uint64_t
+frame_capture::written() const
+{
+	return m_written.load();
+}
+
+std::uint64_t
+frame_capture::dropped() const
+{
+	return m_dropped;
+}
+
+std::uint64_t
+frame_capture::failed() const
+{
+	return m_failed.load();
+}
+
+void
+frame_capture::write(readback const & t_frame)
+{
+	char name[32];
+	std::snprintf(
+	    name, sizeof(name), "frame_%06llu.%s",
+	    static_cast<unsigned long long>(t_frame.frame),
+	    m_format == capture_format::ppm ? "ppm" : "raw");
+	std::ofstream out(m_directory / name, std::ios::binary);
+	auto const * texels = reinterpret_cast<char const *>(t_frame.memory.mapped());
+	auto const   width  = std::size_t {t_frame.extent.width};
+	auto const   height = std::size_t {t_frame.extent.height};
+	if (m_format == capture_format::raw) {
+		out.write(texels, static_cast<std::streamsize>(width * height * 4));
+	} else {
+		out << "P6\n" << width << ' ' << height << "\n255\n";
+		// a row at a time, dropping alpha and swapping to rgb on the way
+		auto const        bgra = is_bgra(m_image_format);
+		std::vector<char> row(width * 3);
+		for (std::size_t y = 0; y < height; ++y) {
+			auto const * in = texels + y * width * 4;
+			for (std::size_t x = 0; x < width; ++x) {
+				row[x * 3 + 0] = in[x * 4 + (bgra ? 2 : 0)];
+				row[x * 3 + 1] = in[x * 4 + 1];
+				row[x * 3 + 2] = in[x * 4 + (bgra ? 0 : 2)];
+			}
+			out.write(row.data(), static_cast<std::streamsize>(row.size()));
+		}
+	}
+	if (out.good())
+		m_written.fetch_add(1, std::memory_order_relaxed);
+	else
+		m_failed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+frame_capture::run()
+{
+	for (;;) {
+		std::size_t index;
+		{
+			std::unique_lock lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+			index = m_queue.front();
+			m_queue.pop_front();
+		}
+		write(m_ring[index]);
+		{
+			// under the lock, so flush can't miss the last one
+			std::lock_guard lock(m_mutex);
+			m_ring[index].status.store(state::free, std::memory_order_release);
+		}
+		m_idle.notify_all();
+	}
+}
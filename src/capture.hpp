@@ -0,0 +1,133 @@
+#ifndef CAPTURE_HPP_INCLUDED
+#define CAPTURE_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "allocator.hpp"
+
+enum class capture_format{
+	ppm, ///< binary rgb, 8 bits per channel
+	raw, ///< the texels as they are in the image
+};
+
+///
+///@return the format named ppm or raw, nullopt for anything else
+///
+std::optional<capture_format> parse_capture_format(std::string_view t_name);
+
+///
+///@brief copies rendered frames into host memory and writes them to disk
+/// on a thread of its own
+///
+/// The frame's command buffer copies the image into the next readback
+/// buffer of a ring that stays mapped. Once the frame has retired the
+/// buffer goes to the writer thread, which writes it straight from the
+/// mapped memory and hands it back. The render thread never waits on the
+/// writer: when the ring is full the frame isn't captured and counted as
+/// dropped, a deeper ring absorbs slower disks. A frame bigger than the
+/// next buffer, after the window grew, replaces that buffer with one that
+/// fits, it's neither copied to nor written from while it's free.
+///
+class frame_capture{
+	enum class state{
+		free,
+		copying, // the copy is recorded, the frame hasn't retired yet
+		writing,
+	};
+	struct readback{
+		vk::UniqueBuffer   buffer;
+		allocation         memory;
+		vk::DeviceSize     capacity = 0;
+		std::atomic<state> status {state::free};
+		std::uint64_t      frame  = 0;
+		vk::Extent2D       extent = {};
+	};
+
+	device_allocator &            m_alloc;
+	vk::Device                    m_dev;
+	capture_format                m_format;
+	vk::Format                    m_image_format;
+	std::filesystem::path         m_directory;
+	std::unique_ptr<readback[]>   m_ring;
+	std::size_t                   m_depth;
+	std::size_t                   m_next    = 0; // buffer the next copy goes to
+	std::size_t                   m_retired = 0; // oldest copy not handed over
+	std::uint64_t                 m_dropped = 0;
+	std::atomic<std::uint64_t>    m_written {0};
+	std::atomic<std::uint64_t>    m_failed {0};
+	std::deque<std::size_t>       m_queue;
+	std::mutex                    m_mutex;
+	std::condition_variable       m_wake;
+	std::condition_variable       m_idle;
+	bool                          m_stop = false;
+	std::thread                   m_thread;
+
+	void allocate(readback & t_frame, vk::DeviceSize t_capacity);
+	void run();
+	void write(readback const & t_frame);
+
+	public:
+	///
+	///@param[in] t_format format of the captured images, 8 bit rgba or
+	/// bgra
+	///@param[in] t_extent extent the buffers are sized for up front
+	///@param[in] t_depth number of readback buffers
+	///@throws std::runtime_error if the image format can't be captured
+	///
+	frame_capture(
+	    device_allocator &            t_alloc,
+	    vk::Device const &            t_dev,
+	    vk::Format                    t_format,
+	    vk::Extent2D                  t_extent,
+	    std::size_t                   t_depth,
+	    std::filesystem::path const & t_directory,
+	    capture_format                t_file_format);
+	frame_capture(frame_capture const &) = delete;
+	frame_capture & operator=(frame_capture const &) = delete;
+	///
+	///@brief writes what's been handed over, the device has to be idle
+	///
+	~frame_capture();
+
+	///
+	///@brief records the copy of the image, which is in t_layout before
+	/// and after, into the frame's command buffer
+	///
+	///@return false if the frame is dropped
+	///
+	bool record(
+	    vk::CommandBuffer const & t_cmd,
+	    vk::Image const &         t_image,
+	    vk::ImageLayout           t_layout,
+	    vk::Extent2D              t_extent,
+	    std::uint64_t             t_frame);
+
+	///
+	///@brief hands the copies of frames before t_frame to the writer, they
+	/// must have retired
+	///
+	void finished_before(std::uint64_t t_frame);
+
+	///
+	///@brief hands every copy to the writer and waits until they are all
+	/// written, the device has to be idle
+	///
+	void flush();
+
+	std::uint64_t written() const;
+	std::uint64_t dropped() const;
+	std::uint64_t failed() const; ///< frames the writer couldn't write
+};
+
+#endif // CAPTURE_HPP_INCLUDED
@@ -0,0 +1,180 @@
+#include "culling.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+vk::PhysicalDeviceFeatures
+gpu_culler::required_features()
+{
+	return {
+	    .multiDrawIndirect         = true,
+	    .drawIndirectFirstInstance = true,
+	};
+}
+
+bool
+gpu_culler::supported(vk::PhysicalDevice const & t_phys, std::uint32_t t_max_objects)
+{
+	auto const features = t_phys.getFeatures();
+	return features.multiDrawIndirect && features.drawIndirectFirstInstance &&
+	       t_phys.getProperties().limits.maxDrawIndirectCount >= t_max_objects;
+}
+
+gpu_culler::gpu_culler(
+    device_allocator &        t_alloc,
+    vk::Device const &        t_dev,
+    vk::PipelineCache const & t_cache,
+    std::uint32_t             t_slots,
+    std::uint32_t             t_max_objects,
+    bool                      t_draw_count)
+    : m_dev(t_dev)
+    , m_max_objects(t_max_objects)
+    , m_draw_count(t_draw_count)
+{
+	// objects, draw list and draw count
+	std::array<vk::DescriptorSetLayoutBinding, 3> bindings;
+	for (std::uint32_t i = 0; i < bindings.size(); ++i)
+		bindings[i] = {
+		    .binding         = i,
+		    .descriptorType  = vk::DescriptorType::eStorageBuffer,
+		    .descriptorCount = 1,
+		    .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+		};
+	m_set_layout = m_dev.createDescriptorSetLayoutUnique({
+	    .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+	    .pBindings    = bindings.data(),
+	});
+	vk::PushConstantRange const constants {
+	    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+	    .offset     = 0,
+	    .size       = sizeof(cull_constants),
+	};
+	m_layout = m_dev.createPipelineLayoutUnique({
+	    .setLayoutCount         = 1,
+	    .pSetLayouts            = &*m_set_layout,
+	    .pushConstantRangeCount = 1,
+	    .pPushConstantRanges    = &constants,
+	});
+
+	m_pipeline = make_compute_pipeline(m_dev, t_cache, "cull", *m_layout);
+
+	vk::DescriptorPoolSize const pool_size {
+	    .type            = vk::DescriptorType::eStorageBuffer,
+	    .descriptorCount = t_slots * static_cast<std::uint32_t>(bindings.size()),
+	};
+	m_descriptor_pool = m_dev.createDescriptorPoolUnique({
+	    .maxSets       = t_slots,
+	    .poolSizeCount = 1,
+	    .pPoolSizes    = &pool_size,
+	});
+	std::vector<vk::DescriptorSetLayout> const layouts(t_slots, *m_set_layout);
+	auto const sets = m_dev.allocateDescriptorSets({
+	    .descriptorPool     = *m_descriptor_pool,
+	    .descriptorSetCount = t_slots,
+	    .pSetLayouts        = layouts.data(),
+	});
+
+	using buf = vk::BufferUsageFlagBits;
+	auto const usage = buf::eStorageBuffer | buf::eIndirectBuffer | buf::eTransferDst;
+	m_slots.reserve(t_slots);
+	for (auto const & set : sets) {
+		slot_buffers slot {
+		    .commands = m_dev.createBufferUnique({
+		        .size        = std::max(t_max_objects, 1u) * sizeof(vk::DrawIndexedIndirectCommand),
+		        .usage       = usage,
+		        .sharingMode = vk::SharingMode::eExclusive,
+		    }),
+		    .commands_memory = {},
+		    .count = m_dev.createBufferUnique({
+		        .size        = sizeof(std::uint32_t),
+		        .usage       = usage,
+		        .sharingMode = vk::SharingMode::eExclusive,
+		    }),
+		    .count_memory = {},
+		    .set          = set,
+		};
+		slot.commands_memory = t_alloc.bind(*slot.commands, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		slot.count_memory    = t_alloc.bind(*slot.count, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		m_slots.push_back(std::move(slot));
+	}
+}
+
+void
+gpu_culler::record(
+    vk::CommandBuffer const & t_cmd,
+    std::uint32_t             t_slot,
+    vk::Buffer const &        t_objects,
+    cull_constants const &    t_constants) const
+{
+	if (t_constants.object_count > m_max_objects)
+		throw std::runtime_error("too many objects to cull");
+	auto const & slot = m_slots.at(t_slot);
+	// the objects may have been replaced since the slot was last used
+	std::array<vk::DescriptorBufferInfo, 3> const infos {{
+	    {.buffer = t_objects, .offset = 0, .range = VK_WHOLE_SIZE},
+	    {.buffer = *slot.commands, .offset = 0, .range = VK_WHOLE_SIZE},
+	    {.buffer = *slot.count, .offset = 0, .range = VK_WHOLE_SIZE},
+	}};
+	std::array<vk::WriteDescriptorSet, 3> writes;
+	for (std::uint32_t i = 0; i < writes.size(); ++i)
+		writes[i] = {
+		    .dstSet          = slot.set,
+		    .dstBinding      = i,
+		    .dstArrayElement = 0,
+		    .descriptorCount = 1,
+		    .descriptorType  = vk::DescriptorType::eStorageBuffer,
+		    .pBufferInfo     = &infos[i],
+		};
+	m_dev.updateDescriptorSets(writes, nullptr);
+
+	using psf = vk::PipelineStageFlagBits;
+	using af  = vk::AccessFlagBits;
+	// without the count the draw reads every entry, the ones the shader
+	// doesn't write have to stay zero
+	if (!m_draw_count)
+		t_cmd.fillBuffer(*slot.commands, 0, VK_WHOLE_SIZE, 0);
+	t_cmd.fillBuffer(*slot.count, 0, VK_WHOLE_SIZE, 0);
+	t_cmd.pipelineBarrier(
+	    psf::eTransfer,
+	    psf::eComputeShader,
+	    {},
+	    vk::MemoryBarrier {
+	        .srcAccessMask = af::eTransferWrite,
+	        .dstAccessMask = af::eShaderRead | af::eShaderWrite,
+	    },
+	    nullptr,
+	    nullptr);
+	t_cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *m_pipeline.pipeline);
+	t_cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_layout, 0, slot.set, nullptr);
+	t_cmd.pushConstants<cull_constants>(*m_layout, vk::ShaderStageFlagBits::eCompute, 0, t_constants);
+	t_cmd.dispatch((t_constants.object_count + 63) / 64, 1, 1);
+	t_cmd.pipelineBarrier(
+	    psf::eComputeShader,
+	    psf::eDrawIndirect,
+	    {},
+	    vk::MemoryBarrier {
+	        .srcAccessMask = af::eShaderWrite,
+	        .dstAccessMask = af::eIndirectCommandRead,
+	    },
+	    nullptr,
+	    nullptr);
+}
+
+void
+gpu_culler::draw(
+    vk::CommandBuffer const & t_cmd,
+    std::uint32_t             t_slot,
+    std::uint32_t             t_object_count) const
+{
+	auto const & slot = m_slots.at(t_slot);
+	if (m_draw_count) {
+		t_cmd.drawIndexedIndirectCount(
+		    *slot.commands,
+		    0,
+		    *slot.count,
+		    0,
+		    t_object_count,
+		    sizeof(vk::DrawIndexedIndirectCommand));
+		return;
+	}
+	t_cmd.drawIndexedIndirect(*slot.commands, 0, t_object_count, sizeof(vk::DrawIndexedIndirectCommand));
+}
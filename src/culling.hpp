@@ -0,0 +1,101 @@
+#ifndef CULLING_HPP_INCLUDED
+#define CULLING_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "allocator.hpp"
+#include "shaders.hpp"
+
+///
+///@brief push constants of the culling shader
+///
+struct cull_constants{
+	std::array<float, 2> offset; ///< view transform, as in draw_item
+	float                scale;
+	float                radius; ///< bounding radius of the mesh
+	std::uint32_t        object_count;
+	std::uint32_t        index_count;
+};
+
+///
+///@brief frustum culls the instances on the gpu and draws the survivors
+/// with a single indirect multi-draw
+///
+/// A compute pass tests every object's bounding circle against the view
+/// and appends a vk::DrawIndexedIndirectCommand per visible object, its
+/// firstInstance selecting the object, and counts them. With
+/// drawIndirectCount the draw reads the count and only the count is cleared
+/// beforehand. On a 1.0 device the draw covers the whole list, which is
+/// cleared so the entries past the count draw nothing. Every frame slot has
+/// its own draw list, so a frame in flight can still be drawing from the
+/// previous one.
+///
+class gpu_culler{
+	struct slot_buffers{
+		vk::UniqueBuffer  commands;
+		allocation        commands_memory;
+		vk::UniqueBuffer  count;
+		allocation        count_memory;
+		vk::DescriptorSet set;
+	};
+
+	vk::Device                      m_dev;
+	std::uint32_t                   m_max_objects;
+	bool                            m_draw_count;
+	vk::UniqueDescriptorSetLayout   m_set_layout;
+	vk::UniquePipelineLayout        m_layout;
+	compute_pipeline_t              m_pipeline;
+	vk::UniqueDescriptorPool        m_descriptor_pool;
+	std::vector<slot_buffers>       m_slots;
+
+	public:
+	///
+	///@brief the device features the indirect draw relies on, enable them
+	/// when creating the device
+	///
+	static vk::PhysicalDeviceFeatures required_features();
+
+	///
+	///@return true if the device supports culling t_max_objects objects
+	///
+	static bool supported(vk::PhysicalDevice const & t_phys, std::uint32_t t_max_objects);
+
+	///
+	///@param[in] t_slots number of frames in flight
+	///@param[in] t_max_objects most objects ever culled at once
+	///@param[in] t_draw_count whether the device was created with the
+	/// drawIndirectCount feature of Vulkan 1.2
+	///
+	gpu_culler(
+	    device_allocator &        t_alloc,
+	    vk::Device const &        t_dev,
+	    vk::PipelineCache const & t_cache,
+	    std::uint32_t             t_slots,
+	    std::uint32_t             t_max_objects,
+	    bool                      t_draw_count);
+
+	///
+	///@brief records clearing the slot's draw list and culling into it
+	///
+	///Must be recorded outside of a render pass, the slot's previous frame
+	///has to have retired. The objects are read as an array of instance.
+	///
+	void record(
+	    vk::CommandBuffer const & t_cmd,
+	    std::uint32_t             t_slot,
+	    vk::Buffer const &        t_objects,
+	    cull_constants const &    t_constants) const;
+
+	///
+	///@brief draws the slot's draw list with whatever is bound
+	///
+	void draw(
+	    vk::CommandBuffer const & t_cmd,
+	    std::uint32_t             t_slot,
+	    std::uint32_t             t_object_count) const;
+};
+
+#endif // CULLING_HPP_INCLUDED
@@ -0,0 +1,224 @@
+#include "debug_log.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+template<std::size_t N>
+void
+copy_truncated(std::array<char, N> & t_dst, char const * t_src)
+{
+	auto const length = t_src ? std::min(std::strlen(t_src), N - 1) : 0;
+	std::memcpy(t_dst.data(), t_src, length);
+	t_dst[length] = '\0';
+}
+
+} // namespace
+
+std::optional<vk::DebugUtilsMessageSeverityFlagsEXT>
+parse_severity(std::string_view t_name)
+{
+	using dms = vk::DebugUtilsMessageSeverityFlagBitsEXT;
+	vk::DebugUtilsMessageSeverityFlagsEXT out = dms::eError;
+	if (t_name == "error")
+		return out;
+	out |= dms::eWarning;
+	if (t_name == "warning")
+		return out;
+	out |= dms::eInfo;
+	if (t_name == "info")
+		return out;
+	out |= dms::eVerbose;
+	if (t_name == "verbose")
+		return out;
+	return std::nullopt;
+}
+
+debug_log::debug_log(std::ostream & t_out, std::size_t t_capacity)
+    : m_out(t_out)
+    , m_cells(new cell[std::bit_ceil(std::max<std::size_t>(t_capacity, 2))])
+    , m_mask(std::bit_ceil(std::max<std::size_t>(t_capacity, 2)) - 1)
+{
+	for (std::size_t i = 0; i <= m_mask; ++i)
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	m_thread = std::thread(&debug_log::run, this);
+}
+
+debug_log::~debug_log()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+	summarise();
+}
+
+vk::DebugUtilsMessengerCreateInfoEXT
+debug_log::messenger_info(vk::DebugUtilsMessageSeverityFlagsEXT t_severities)
+{
+	using dmt = vk::DebugUtilsMessageTypeFlagBitsEXT;
+	return {
+	    .messageSeverity = t_severities,
+	    .messageType     = dmt::eGeneral | dmt::ePerformance | dmt::eValidation,
+	    .pfnUserCallback = callback,
+	    .pUserData       = this,
+	};
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL
+debug_log::callback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT       t_severity,
+    VkDebugUtilsMessageTypeFlagsEXT              t_types,
+    VkDebugUtilsMessengerCallbackDataEXT const * t_data,
+    void *                                       t_log)
+{
+	auto & log = *static_cast<debug_log *>(t_log);
+	entry e {
+	    .severity = static_cast<vk::DebugUtilsMessageSeverityFlagBitsEXT>(t_severity),
+	    .types    = static_cast<vk::DebugUtilsMessageTypeFlagsEXT>(t_types),
+	    .id       = t_data->messageIdNumber,
+	    .id_name  = {},
+	    .text     = {},
+	};
+	copy_truncated(e.id_name, t_data->pMessageIdName);
+	copy_truncated(e.text, t_data->pMessage);
+	if (!log.push(e))
+		log.m_dropped.fetch_add(1, std::memory_order_relaxed);
+	return VK_FALSE;
+}
+
+bool
+debug_log::push(entry const & t_entry)
+{
+	auto pos = m_enqueue.load(std::memory_order_relaxed);
+	for (;;) {
+		auto &     c   = m_cells[pos & m_mask];
+		auto const seq = c.sequence.load(std::memory_order_acquire);
+		if (seq == pos) {
+			if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				c.message = t_entry;
+				c.sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		} else if (seq < pos) {
+			// the consumer hasn't freed the cell from the previous lap
+			return false;
+		} else {
+			pos = m_enqueue.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool
+debug_log::pop(entry & t_entry)
+{
+	auto & c = m_cells[m_dequeue & m_mask];
+	if (c.sequence.load(std::memory_order_acquire) != m_dequeue + 1)
+		return false;
+	t_entry = c.message;
+	c.sequence.store(m_dequeue + m_mask + 1, std::memory_order_release);
+	++m_dequeue;
+	return true;
+}
+
+void
+debug_log::write(entry const & t_entry)
+{
+	using dmt = vk::DebugUtilsMessageTypeFlagBitsEXT;
+	using dms = vk::DebugUtilsMessageSeverityFlagBitsEXT;
+	std::string_view const id_name = t_entry.id_name.data();
+	std::string_view const text    = t_entry.text.data();
+	// messages without an id are told apart by their text
+	auto const key = !id_name.empty() ? std::string(id_name)
+	                 : t_entry.id     ? std::to_string(t_entry.id)
+	                                  : std::string(text);
+	auto [it, fresh] = m_kinds.try_emplace(key);
+	auto & k         = it->second;
+	if (fresh) {
+		k.severity = t_entry.severity;
+		k.types    = t_entry.types;
+		k.name     = key.substr(0, 80);
+	}
+	++k.count;
+	auto const now = std::chrono::steady_clock::now();
+	if (!fresh && now - k.last_print < std::chrono::seconds(1))
+		return;
+	m_out << "["
+	      << (t_entry.severity & dms::eVerbose ? 'V' : '-')
+	      << (t_entry.severity & dms::eInfo    ? 'I' : '-')
+	      << (t_entry.severity & dms::eWarning ? 'W' : '-')
+	      << (t_entry.severity & dms::eError   ? 'E' : '-')
+	      << "]["
+	      << (t_entry.types & dmt::eGeneral     ? 'G' : '-')
+	      << (t_entry.types & dmt::ePerformance ? 'P' : '-')
+	      << (t_entry.types & dmt::eValidation  ? 'V' : '-')
+	      << "]validation layer: ";
+	if (fresh)
+		m_out << text << '\n';
+	else
+		m_out << k.name << " repeated " << k.count - k.printed << " times\n";
+	k.printed    = k.count;
+	k.last_print = now;
+}
+
+void
+debug_log::drain()
+{
+	entry e;
+	bool  wrote = false;
+	while (pop(e)) {
+		write(e);
+		wrote = true;
+	}
+	if (wrote)
+		m_out.flush();
+}
+
+void
+debug_log::run()
+{
+	for (;;) {
+		drain();
+		std::unique_lock lock(m_mutex);
+		// producers never take the lock, so the logger looks for new
+		// messages on its own every now and then
+		if (m_wake.wait_for(lock, std::chrono::milliseconds(20), [&] { return m_stop; }))
+			break;
+	}
+	drain();
+}
+
+void
+debug_log::summarise()
+{
+	using dmt = vk::DebugUtilsMessageTypeFlagBitsEXT;
+	std::uint64_t            total = 0;
+	std::vector<kind const *> repeated;
+	std::vector<kind const *> performance;
+	for (auto const & [key, k] : m_kinds) {
+		total += k.count;
+		if (k.count > 1)
+			repeated.push_back(&k);
+		if (k.types & dmt::ePerformance)
+			performance.push_back(&k);
+	}
+	auto const dropped = m_dropped.load();
+	if (!total && !dropped)
+		return;
+	auto const by_count = [](kind const * a, kind const * b) { return a->count > b->count; };
+	std::sort(repeated.begin(), repeated.end(), by_count);
+	std::sort(performance.begin(), performance.end(), by_count);
+	m_out << "validation layer: " << total << " messages of " << m_kinds.size()
+	      << " kinds, " << dropped << " dropped\n";
+	for (auto const * k : repeated)
+		m_out << "  " << k->count << " x " << k->name << '\n';
+	if (!performance.empty())
+		m_out << "performance warnings:\n";
+	for (auto const * k : performance)
+		m_out << "  " << k->count << " x " << k->name << '\n';
+	m_out.flush();
+}
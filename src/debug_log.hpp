@@ -0,0 +1,107 @@
+#ifndef DEBUG_LOG_HPP_INCLUDED
+#define DEBUG_LOG_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+///
+///@return the severities at or above the named one (error, warning, info
+/// or verbose), nullopt for anything else
+///
+std::optional<vk::DebugUtilsMessageSeverityFlagsEXT>
+parse_severity(std::string_view t_name);
+
+///
+///@brief collects debug messenger messages without slowing down the
+/// threads that trigger them
+///
+/// The callback copies the message into a fixed size lock-free ring, which
+/// any number of threads can push into at once, and returns. A logger
+/// thread drains the ring and writes the messages out. Messages are told
+/// apart by their id, the first one of a kind is written in full and
+/// repeats are only counted, with a line at most once a second while they
+/// keep coming. The destructor writes how often every repeated message and
+/// every performance warning showed up. When the ring is full messages are
+/// dropped, and counted as well.
+///
+class debug_log{
+	struct entry{
+		vk::DebugUtilsMessageSeverityFlagBitsEXT severity;
+		vk::DebugUtilsMessageTypeFlagsEXT        types;
+		std::int32_t                             id;
+		std::array<char, 64>                     id_name;
+		std::array<char, 1024>                   text;
+	};
+	// the sequence number tells who may use the cell next, the producer that
+	// claimed position p when it equals p, the consumer when it's p + 1
+	struct cell{
+		std::atomic<std::size_t> sequence;
+		entry                    message;
+	};
+	struct kind{
+		vk::DebugUtilsMessageSeverityFlagBitsEXT severity;
+		vk::DebugUtilsMessageTypeFlagsEXT        types;
+		std::string                              name;
+		std::uint64_t                            count   = 0;
+		std::uint64_t                            printed = 0; // count when last written
+		std::chrono::steady_clock::time_point    last_print;
+	};
+
+	std::ostream &                     m_out;
+	std::unique_ptr<cell[]>            m_cells;
+	std::size_t                        m_mask;
+	std::atomic<std::size_t>           m_enqueue {0};
+	std::size_t                        m_dequeue = 0;
+	std::atomic<std::uint64_t>         m_dropped {0};
+	std::map<std::string, kind>        m_kinds;
+	std::mutex                         m_mutex;
+	std::condition_variable            m_wake;
+	bool                               m_stop = false;
+	std::thread                        m_thread;
+
+	bool push(entry const & t_entry);
+	bool pop(entry & t_entry);
+	void write(entry const & t_entry);
+	void drain();
+	void run();
+	void summarise();
+
+	public:
+	///
+	///@param[in] t_capacity messages the ring holds, rounded up to a power
+	/// of two
+	///
+	explicit debug_log(std::ostream & t_out, std::size_t t_capacity = 1024);
+	debug_log(debug_log const &) = delete;
+	debug_log & operator=(debug_log const &) = delete;
+	~debug_log();
+
+	///
+	///@brief create info of a messenger that reports into the log, chain it
+	/// into the instance create info
+	///
+	vk::DebugUtilsMessengerCreateInfoEXT
+	messenger_info(vk::DebugUtilsMessageSeverityFlagsEXT t_severities);
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL callback(
+	    VkDebugUtilsMessageSeverityFlagBitsEXT       t_severity,
+	    VkDebugUtilsMessageTypeFlagsEXT              t_types,
+	    VkDebugUtilsMessengerCallbackDataEXT const * t_data,
+	    void *                                       t_log);
+};
+
+#endif // DEBUG_LOG_HPP_INCLUDED
@@ -0,0 +1,277 @@
+#include "device.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include "helper.hpp"
+
+namespace {
+
+std::int64_t
+type_score(vk::PhysicalDeviceType t_type)
+{
+	switch (t_type) {
+	case vk::PhysicalDeviceType::eDiscreteGpu:   return 10000;
+	case vk::PhysicalDeviceType::eIntegratedGpu: return 4000;
+	case vk::PhysicalDeviceType::eVirtualGpu:    return 2000;
+	case vk::PhysicalDeviceType::eOther:         return 1000;
+	case vk::PhysicalDeviceType::eCpu:           return 0;
+	}
+	return 0;
+}
+
+std::int64_t
+score(device_report const & t_report)
+{
+	if (!t_report.suitable())
+		return -1;
+	// a point per 64 MiB of local memory, capped so that no amount of
+	// shared system memory lifts an integrated gpu over a discrete one
+	auto const memory = std::min<std::int64_t>(
+	    static_cast<std::int64_t>(t_report.local_memory >> 26), 2000);
+	return type_score(t_report.properties.deviceType) + memory +
+	       (t_report.transfer ? 300 : 0) + (t_report.compute ? 300 : 0) +
+	       (t_report.graphics->index == t_report.present->index ? 200 : 0);
+}
+
+vk::DeviceSize
+largest_local_heap(vk::PhysicalDevice const & t_dev)
+{
+	auto const         memory = t_dev.getMemoryProperties();
+	vk::DeviceSize     out    = 0;
+	for (std::uint32_t i = 0; i < memory.memoryHeapCount; ++i)
+		if (memory.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+			out = std::max(out, memory.memoryHeaps[i].size);
+	return out;
+}
+
+template<class Pred>
+std::optional<queue_family>
+find_family(std::vector<queue_family> const & t_families, Pred t_pred)
+{
+	auto const it = std::find_if(t_families.begin(), t_families.end(), t_pred);
+	return it != t_families.end() ? std::optional(*it) : std::nullopt;
+}
+
+device_report
+make_report(
+    std::uint32_t                 t_index,
+    vk::PhysicalDevice const &    t_dev,
+    vk::SurfaceKHR const &        t_surface,
+    std::span<char const * const> t_extensions)
+{
+	auto const families = enumerate_queue_families(t_dev);
+	auto const presents = [&](queue_family const & t_family) {
+		return t_surface ? bool(t_dev.getSurfaceSupportKHR(t_family.index, t_surface))
+		                 : t_family.graphics;
+	};
+	device_report out {
+	    .index        = t_index,
+	    .device       = t_dev,
+	    .properties   = t_dev.getProperties(),
+	    .local_memory = largest_local_heap(t_dev),
+	    .extensions   = check_extension_support(t_dev, t_extensions),
+	    // a graphics family that presents as well saves the swapchain images
+	    // from changing hands between queues
+	    .graphics = find_family(families, [&](queue_family const & a) {
+		    return a.graphics && presents(a);
+	    }),
+	    .present  = std::nullopt,
+	    .transfer = find_family(families, [](queue_family const & a) {
+		    return a.transfer && !a.graphics && !a.compute;
+	    }),
+	    .compute  = find_family(families, [](queue_family const & a) {
+		    return a.compute && !a.graphics;
+	    }),
+	    .score    = 0,
+	};
+	if (out.graphics) {
+		out.present = out.graphics;
+	} else {
+		out.graphics = find_family(families, [](queue_family const & a) {
+			return a.graphics;
+		});
+		out.present  = find_family(families, presents);
+	}
+	out.score = score(out);
+	return out;
+}
+
+std::string_view
+type_name(vk::PhysicalDeviceType t_type)
+{
+	switch (t_type) {
+	case vk::PhysicalDeviceType::eDiscreteGpu:   return "discrete gpu";
+	case vk::PhysicalDeviceType::eIntegratedGpu: return "integrated gpu";
+	case vk::PhysicalDeviceType::eVirtualGpu:    return "virtual gpu";
+	case vk::PhysicalDeviceType::eCpu:           return "cpu";
+	case vk::PhysicalDeviceType::eOther:         return "other";
+	}
+	return "unknown";
+}
+
+void
+print_family(std::ostream & t_out, std::string_view t_name, std::optional<queue_family> const & t_family)
+{
+	t_out << ", " << t_name << ' ';
+	if (t_family)
+		t_out << t_family->index;
+	else
+		t_out << '-';
+}
+
+} // namespace
+
+std::vector<queue_family>
+enumerate_queue_families(vk::PhysicalDevice const & t_d){
+	auto const families = t_d.getQueueFamilyProperties();
+	auto const numbers  = range(static_cast<std::uint32_t>(families.size()));
+	std::vector<queue_family> out;
+	out.reserve(families.size());
+	std::transform( families.begin(), families.end(), numbers.begin(),
+	    std::back_inserter(out),
+	    [](auto const & t_f, auto i) -> queue_family {
+            using qfb = vk::QueueFlagBits;
+		    return {
+		        i,
+		        t_f.queueCount,
+		        bool(t_f.queueFlags & qfb::eGraphics),
+		        bool(t_f.queueFlags & qfb::eCompute),
+		        bool(t_f.queueFlags & qfb::eTransfer),
+		        bool(t_f.queueFlags & qfb::eSparseBinding),
+		        bool(t_f.queueFlags & qfb::eProtected),
+		        t_f.timestampValidBits};
+	    });
+	return out;
+}
+
+bool
+check_extension_support(
+    vk::PhysicalDevice const &    t_dev,
+    std::span<char const * const> t_extensions){
+	std::vector<char const *> sorted_extensions(t_extensions.size());
+	std::partial_sort_copy( t_extensions.begin(), t_extensions.end(),
+	    sorted_extensions.begin(),
+	    sorted_extensions.end(),
+	    [](char const * a, char const * b) {
+		    return std::strcmp(a, b) < 0;
+	    });
+
+	std::vector<vk::ExtensionProperties> dev_extensions =
+	    t_dev.enumerateDeviceExtensionProperties();
+	std::sort(
+	    dev_extensions.begin(),
+	    dev_extensions.end(),
+	    [](auto const & a, auto const & b) {
+		    return std::strcmp(a.extensionName, b.extensionName) < 0;
+	    });
+	std::vector<char const *> dev_extensions_stripped(dev_extensions.size());
+	std::transform(
+	    dev_extensions.begin(),
+	    dev_extensions.end(),
+	    dev_extensions_stripped.begin(),
+	    [](auto const & a) {
+		    return a.extensionName.data();
+	    });
+	return std::includes(
+	    dev_extensions_stripped.begin(),
+	    dev_extensions_stripped.end(),
+	    sorted_extensions.begin(),
+	    sorted_extensions.end(),
+	    [](auto a, auto b) {
+		    return std::strcmp(a, b) < 0;
+	    });
+}
+
+bool
+device_report::suitable() const
+{
+	return extensions && graphics && present;
+}
+
+std::vector<device_report>
+rate_devices(
+    vk::Instance const &          t_inst,
+    vk::SurfaceKHR const &        t_surface,
+    std::span<char const * const> t_extensions)
+{
+	auto const devices = t_inst.enumeratePhysicalDevices();
+	std::vector<device_report> out;
+	out.reserve(devices.size());
+	for (std::uint32_t i = 0; i < devices.size(); ++i)
+		out.push_back(make_report(i, devices[i], t_surface, t_extensions));
+	return out;
+}
+
+void
+print_device_reports(std::ostream & t_out, std::span<device_report const> t_reports)
+{
+	for (auto const & r : t_reports) {
+		auto const version = r.properties.apiVersion;
+		t_out << '[' << r.index << "] " << r.properties.deviceName.data()
+		      << " (" << type_name(r.properties.deviceType) << ", vulkan "
+		      << VK_API_VERSION_MAJOR(version) << '.' << VK_API_VERSION_MINOR(version)
+		      << '.' << VK_API_VERSION_PATCH(version) << ")\n"
+		      << "    " << (r.local_memory >> 20) << " MiB device local";
+		print_family(t_out, "graphics", r.graphics);
+		print_family(t_out, "present", r.present);
+		print_family(t_out, "transfer", r.transfer);
+		print_family(t_out, "compute", r.compute);
+		t_out << '\n' << "    ";
+		if (r.suitable())
+			t_out << "score " << r.score << '\n';
+		else
+			t_out << "unsuitable:" << (r.extensions ? "" : " missing extensions")
+			      << (r.graphics ? "" : " no graphics family")
+			      << (r.present ? "" : " no present family") << '\n';
+	}
+}
+
+std::size_t
+choose_device(
+    std::span<device_report const>  t_reports,
+    std::optional<std::string_view> t_choice)
+{
+	if (!t_choice) {
+		auto const best = std::max_element(
+		    t_reports.begin(), t_reports.end(), [](auto const & a, auto const & b) {
+			    return a.score < b.score;
+		    });
+		if (best == t_reports.end() || !best->suitable())
+			throw std::runtime_error("No suitable vulkan device");
+		return static_cast<std::size_t>(best - t_reports.begin());
+	}
+	// an index if it parses as one, a part of the name otherwise
+	auto const  choice = *t_choice;
+	std::size_t index  = 0;
+	auto const [end, ec] = std::from_chars(choice.data(), choice.data() + choice.size(), index);
+	if (ec != std::errc {} || end != choice.data() + choice.size()) {
+		auto const it = std::find_if(t_reports.begin(), t_reports.end(), [&](auto const & r) {
+			return std::string_view(r.properties.deviceName.data()).find(choice) !=
+			       std::string_view::npos;
+		});
+		index = static_cast<std::size_t>(it - t_reports.begin());
+	}
+	if (index >= t_reports.size())
+		throw std::runtime_error("no vulkan device matches --device=" + std::string(choice));
+	if (!t_reports[index].suitable())
+		throw std::runtime_error(
+		    std::string(t_reports[index].properties.deviceName.data()) +
+		    " can't be used, see --list-devices");
+	return index;
+}
+
+pick_devce_and_queues_t
+pick_devce_and_queues(device_report const & t_report)
+{
+	if (!t_report.suitable())
+		throw std::runtime_error("No suitable vulkan device");
+	return {
+	    t_report.device,
+	    *t_report.graphics,
+	    *t_report.present,
+	    t_report.transfer,
+	    t_report.compute};
+}
@@ -0,0 +1,110 @@
+#ifndef DEVICE_HPP_INCLUDED
+#define DEVICE_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+struct queue_family {
+	std::uint32_t index;
+	std::uint32_t count;
+	bool graphics;
+	bool compute;
+	bool transfer;
+	bool sparse_binding;
+	bool protected_memory;
+	std::uint32_t timestamp_valid_bits;
+};
+
+std::vector<queue_family>
+enumerate_queue_families(vk::PhysicalDevice const & t_d);
+
+bool
+check_extension_support(
+    vk::PhysicalDevice const &       t_dev,
+    std::span<char const * const>    t_extensions);
+
+///
+///@brief everything the device selection looks at, gathered once per
+/// device so ranking, listing and picking all agree
+///
+struct device_report{
+	std::uint32_t                index; ///< in enumeration order
+	vk::PhysicalDevice           device;
+	vk::PhysicalDeviceProperties properties;
+	vk::DeviceSize               local_memory; ///< largest device local heap
+	bool                         extensions;   ///< has every required one
+	std::optional<queue_family>  graphics;
+	// the graphics family if it can present, without a surface it stands in
+	// for the present one
+	std::optional<queue_family>  present;
+	// a family that only transfers, copies on it overlap with rendering
+	std::optional<queue_family>  transfer;
+	// a compute family without graphics, for async compute
+	std::optional<queue_family>  compute;
+	std::int64_t                 score; ///< higher is better
+
+	///
+	///@return true if the device can run the renderer at all
+	///
+	bool suitable() const;
+};
+
+///
+///@brief gathers and scores the report of every device of the instance
+///
+/// The score prefers discrete over integrated over virtual over software
+/// devices, then more device local memory, dedicated transfer and compute
+/// families and presenting from the graphics family.
+///
+///@param[in] t_surface surface to present to, may be null when headless
+///@param[in] t_extensions device extensions the renderer needs
+///
+std::vector<device_report>
+rate_devices(
+    vk::Instance const &          t_inst,
+    vk::SurfaceKHR const &        t_surface,
+    std::span<char const * const> t_extensions);
+
+///
+///@brief prints a line per device with its capabilities and score
+///
+void
+print_device_reports(std::ostream & t_out, std::span<device_report const> t_reports);
+
+///
+///@brief picks the device to render with
+///
+///@param[in] t_choice --device, an index into the reports or a part of the
+/// device name, the best scoring suitable device without it
+///@return index into t_reports
+///@throws std::runtime_error if nothing matches or the match is unsuitable
+///
+std::size_t
+choose_device(
+    std::span<device_report const>   t_reports,
+    std::optional<std::string_view>  t_choice);
+
+struct pick_devce_and_queues_t{
+	vk::PhysicalDevice device;
+	queue_family       graphics;
+	queue_family       present;
+	// a family that only transfers, copies on it overlap with rendering
+	std::optional<queue_family> transfer;
+	// a compute family without graphics, for async compute
+	std::optional<queue_family> compute;
+};
+
+///
+///@brief the device and queue families of a suitable report
+///
+pick_devce_and_queues_t
+pick_devce_and_queues(device_report const & t_report);
+
+#endif // DEVICE_HPP_INCLUDED
@@ -0,0 +1,117 @@
+#include "frame.hpp"
+#include <limits>
+#include <stdexcept>
+
+frame_scheduler::frame_scheduler(
+    vk::Device const & t_dev,
+    std::uint32_t      t_frames_in_flight,
+    std::size_t        t_image_count,
+    queue_timeline *   t_timeline):
+	m_dev(t_dev),
+	m_timeline(t_timeline),
+	m_images_in_flight(t_image_count),
+	m_slot_values(t_frames_in_flight, 0),
+	m_image_values(t_image_count, 0)
+{
+	if (!t_frames_in_flight)
+		throw std::invalid_argument("at least one frame must be in flight");
+	m_frames.reserve(t_frames_in_flight);
+	for (std::uint32_t i = 0; i < t_frames_in_flight; ++i)
+	{
+		// fences start signaled so the first wait on every slot passes, as
+		// does waiting for value 0 of a timeline
+		m_frames.push_back({
+		    .image_available = m_dev.createSemaphoreUnique({}),
+		    .in_flight       = m_timeline
+		                           ? vk::UniqueFence {}
+		                           : m_dev.createFenceUnique(
+                                 {.flags = vk::FenceCreateFlagBits::eSignaled}),
+		});
+	}
+}
+
+frame_sync const &
+frame_scheduler::current() const
+{
+	return m_frames[slot()];
+}
+
+std::uint32_t
+frame_scheduler::slot() const
+{
+	return static_cast<std::uint32_t>(m_frame % m_frames.size());
+}
+
+std::uint64_t
+frame_scheduler::frame_number() const
+{
+	return m_frame;
+}
+
+std::uint32_t
+frame_scheduler::frames_in_flight() const
+{
+	return static_cast<std::uint32_t>(m_frames.size());
+}
+
+vk::Fence
+frame_scheduler::fence() const
+{
+	return *current().in_flight;
+}
+
+std::uint64_t
+frame_scheduler::signal_value() const
+{
+	return m_slot_values[slot()];
+}
+
+void
+frame_scheduler::wait_current() const
+{
+	if (m_timeline)
+	{
+		m_timeline->wait(m_slot_values[slot()]);
+		return;
+	}
+	auto const result = m_dev.waitForFences(
+	    *current().in_flight, true, std::numeric_limits<std::uint64_t>::max());
+	if (result != vk::Result::eSuccess)
+		throw std::runtime_error(vk::to_string(result));
+}
+
+void
+frame_scheduler::claim_image(std::uint32_t t_image)
+{
+	if (m_timeline)
+	{
+		auto & last = m_image_values.at(t_image);
+		m_timeline->wait(last);
+		last = m_slot_values[slot()] = m_timeline->reserve();
+		return;
+	}
+	auto const fence = *current().in_flight;
+	auto &     owner = m_images_in_flight.at(t_image);
+	if (owner && owner != fence)
+	{
+		auto const result = m_dev.waitForFences(
+		    owner, true, std::numeric_limits<std::uint64_t>::max());
+		if (result != vk::Result::eSuccess)
+			throw std::runtime_error(vk::to_string(result));
+	}
+	owner = fence;
+	m_dev.resetFences(fence);
+}
+
+void
+frame_scheduler::reset_images(std::size_t t_image_count)
+{
+	m_images_in_flight.assign(t_image_count, vk::Fence {});
+	m_image_values.assign(t_image_count, 0);
+}
+
+void
+frame_scheduler::advance()
+{
+	++m_frame;
+}
@@ -0,0 +1,102 @@
+#ifndef FRAME_HPP_INCLUDED
+#define FRAME_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+#include "timeline.hpp"
+
+///
+///@brief synchronisation primitives owned by a single frame in flight
+///
+/// The semaphore the present waits on isn't among them: a retired frame
+/// only means its submission finished, not that the presentation engine is
+/// done with the semaphore. It belongs to the swapchain image instead,
+/// which can't be acquired again before its last present let go of it.
+///
+struct frame_sync{
+	vk::UniqueSemaphore image_available;
+	vk::UniqueFence     in_flight; ///< null when tracked by a timeline
+};
+
+///
+///@brief keeps up to N frames in flight, so the cpu can record the next frame
+/// while the gpu is still busy with the previous ones
+///
+/// Every frame slot owns its own semaphores and fence, the images in flight
+/// table makes sure an image is not rendered to again before the frame that
+/// last used it has retired, even if the presentation engine hands out images
+/// out of order or there's more slots than images.
+///
+/// With a timeline the fences are replaced by the values the frames signal
+/// on the graphics queue's timeline, every slot and image remembers the
+/// value of the last frame that used it and waits are for that exact value.
+///
+class frame_scheduler{
+	vk::Device                 m_dev;
+	queue_timeline *           m_timeline;
+	std::vector<frame_sync>    m_frames;
+	std::vector<vk::Fence>     m_images_in_flight;
+	std::vector<std::uint64_t> m_slot_values;
+	std::vector<std::uint64_t> m_image_values;
+	std::uint64_t              m_frame = 0;
+
+	public:
+	///
+	///@param[in] t_dev device the primitives are created on
+	///@param[in] t_frames_in_flight how many frames the cpu may run ahead
+	///@param[in] t_image_count number of images the frames are rendered to
+	///@param[in] t_timeline timeline of the graphics queue, fences are used
+	/// without one
+	///
+	frame_scheduler(
+	    vk::Device const & t_dev,
+	    std::uint32_t      t_frames_in_flight,
+	    std::size_t        t_image_count,
+	    queue_timeline *   t_timeline = nullptr);
+
+	frame_sync const & current() const;
+	std::uint32_t      slot() const;
+	std::uint64_t      frame_number() const;
+	std::uint32_t      frames_in_flight() const;
+
+	///
+	///@return the fence the frame's submission signals, null with a timeline
+	///
+	vk::Fence fence() const;
+
+	///
+	///@return the value the frame's submission signals on the timeline
+	///
+	std::uint64_t signal_value() const;
+
+	///
+	///@brief blocks until the previous submission of the current slot retired
+	///
+	void wait_current() const;
+
+	///
+	///@brief waits for the last frame that rendered to the image and hands
+	/// the image over to the current slot, resetting the slot's fence or
+	/// reserving its timeline value
+	///
+	///Must be called after the image has been acquired and right before the
+	///submission that signals fence() or signal_value(), with no other
+	///submission to the graphics queue in between.
+	///
+	void claim_image(std::uint32_t t_image);
+
+	///
+	///@brief forgets which frames own which images, for when the images
+	/// were replaced, e.g. by a recreated swapchain
+	///
+	void reset_images(std::size_t t_image_count);
+
+	///
+	///@brief moves to the next frame slot
+	///
+	void advance();
+};
+
+#endif // FRAME_HPP_INCLUDED
@@ -0,0 +1,117 @@
+#include "gpu_timer.hpp"
+
+gpu_timer::gpu_timer(
+    vk::PhysicalDevice const & t_phys,
+    vk::Device const &         t_dev,
+    std::uint32_t              t_valid_bits,
+    std::uint32_t              t_slots,
+    std::uint32_t              t_passes):
+	m_dev(t_dev),
+	m_passes(t_passes),
+	m_pending(t_slots, false)
+{
+	if (!t_valid_bits || !t_slots || !t_passes)
+		return;
+	m_mask = t_valid_bits >= 64 ? ~std::uint64_t {0} :
+                                  (std::uint64_t {1} << t_valid_bits) - 1;
+	// timestampPeriod is the number of nanoseconds per tick
+	m_period_ms =
+	    static_cast<double>(t_phys.getProperties().limits.timestampPeriod) /
+	    1e6;
+	m_pool = m_dev.createQueryPoolUnique({
+	    .queryType  = vk::QueryType::eTimestamp,
+	    .queryCount = t_slots * t_passes * 2,
+	});
+}
+
+std::uint32_t
+gpu_timer::query(std::uint32_t t_slot, std::uint32_t t_pass) const
+{
+	return (t_slot * m_passes + t_pass) * 2;
+}
+
+bool
+gpu_timer::enabled() const
+{
+	return bool(m_pool);
+}
+
+void
+gpu_timer::reset(vk::CommandBuffer const & t_cmd, std::uint32_t t_slot) const
+{
+	if (enabled())
+		t_cmd.resetQueryPool(*m_pool, query(t_slot, 0), m_passes * 2);
+}
+
+void
+gpu_timer::begin(
+    vk::CommandBuffer const & t_cmd,
+    std::uint32_t             t_slot,
+    std::uint32_t             t_pass) const
+{
+	if (enabled())
+		t_cmd.writeTimestamp(
+		    vk::PipelineStageFlagBits::eTopOfPipe,
+		    *m_pool,
+		    query(t_slot, t_pass));
+}
+
+void
+gpu_timer::end(
+    vk::CommandBuffer const & t_cmd,
+    std::uint32_t             t_slot,
+    std::uint32_t             t_pass) const
+{
+	if (enabled())
+		t_cmd.writeTimestamp(
+		    vk::PipelineStageFlagBits::eBottomOfPipe,
+		    *m_pool,
+		    query(t_slot, t_pass) + 1);
+}
+
+void
+gpu_timer::submitted(std::uint32_t t_slot)
+{
+	m_pending.at(t_slot) = enabled();
+}
+
+std::vector<double>
+gpu_timer::collect(std::uint32_t t_slot)
+{
+	std::vector<double> out;
+	for (auto const & [begin, end] : collect_intervals(t_slot))
+		out.push_back(end - begin);
+	return out;
+}
+
+std::vector<std::pair<double, double>>
+gpu_timer::collect_intervals(std::uint32_t t_slot)
+{
+	if (!m_pending.at(t_slot))
+		return {};
+	m_pending[t_slot] = false;
+	std::vector<std::uint64_t> ticks(m_passes * 2);
+	// no wait bit, the caller guarantees the submission has retired so this
+	// only fails if the queries were never written
+	auto const result = m_dev.getQueryPoolResults(
+	    *m_pool,
+	    query(t_slot, 0),
+	    m_passes * 2,
+	    ticks.size() * sizeof(std::uint64_t),
+	    ticks.data(),
+	    sizeof(std::uint64_t),
+	    vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess)
+		return {};
+	std::vector<std::pair<double, double>> out;
+	out.reserve(m_passes);
+	for (std::size_t i = 0; i < ticks.size(); i += 2)
+	{
+		// the masked difference survives the counter wrapping mid pass
+		auto const begin = static_cast<double>(ticks[i] & m_mask) * m_period_ms;
+		out.emplace_back(
+		    begin,
+		    begin + static_cast<double>((ticks[i + 1] - ticks[i]) & m_mask) * m_period_ms);
+	}
+	return out;
+}
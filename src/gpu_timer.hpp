@@ -0,0 +1,81 @@
+#ifndef GPU_TIMER_HPP_INCLUDED
+#define GPU_TIMER_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+///
+///@brief timestamp queries written around the passes of a command buffer
+///
+/// Every slot (one per command buffer that's in use at the same time) owns a
+/// begin and an end query per pass. Results are only read back once the
+/// submission using the slot is known to have retired, so reading never
+/// stalls. On queues without timestamp support the timer does nothing.
+///
+class gpu_timer{
+	vk::Device          m_dev;
+	vk::UniqueQueryPool m_pool;
+	double              m_period_ms = 0;
+	std::uint64_t       m_mask      = 0;
+	std::uint32_t       m_passes    = 0;
+	std::vector<bool>   m_pending;
+
+	std::uint32_t query(std::uint32_t t_slot, std::uint32_t t_pass) const;
+
+	public:
+	///
+	///@param[in] t_valid_bits timestampValidBits of the queue family the
+	/// command buffers are submitted to
+	///@param[in] t_slots number of command buffers being timed
+	///@param[in] t_passes number of timed passes in each command buffer
+	///
+	gpu_timer(
+	    vk::PhysicalDevice const & t_phys,
+	    vk::Device const &         t_dev,
+	    std::uint32_t              t_valid_bits,
+	    std::uint32_t              t_slots,
+	    std::uint32_t              t_passes);
+
+	bool enabled() const;
+
+	///
+	///@brief records the reset of the slot's queries, must be outside of a
+	/// render pass
+	///
+	void reset(vk::CommandBuffer const & t_cmd, std::uint32_t t_slot) const;
+	void begin(
+	    vk::CommandBuffer const & t_cmd,
+	    std::uint32_t             t_slot,
+	    std::uint32_t             t_pass) const;
+	void end(
+	    vk::CommandBuffer const & t_cmd,
+	    std::uint32_t             t_slot,
+	    std::uint32_t             t_pass) const;
+
+	///
+	///@brief marks the slot as submitted, so its results can be collected
+	///
+	void submitted(std::uint32_t t_slot);
+
+	///
+	///@brief reads back the times of the slot's last submission
+	///
+	///Call only once the submission has retired (its fence was waited on).
+	///
+	///@return milliseconds per pass, empty if there's nothing to collect
+	///
+	std::vector<double> collect(std::uint32_t t_slot);
+
+	///
+	///@brief like collect(), but keeps where the passes started and ended
+	///
+	///@return begin and end of every pass in milliseconds on the device's
+	/// timestamp clock, for lining up passes of different command buffers
+	///
+	std::vector<std::pair<double, double>> collect_intervals(std::uint32_t t_slot);
+};
+
+#endif // GPU_TIMER_HPP_INCLUDED
@@ -10,6 +10,10 @@
 #include <array>
 #include <ranges>
 #include <ranges>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 template<class range_t = std::intmax_t>
 class range{
@@ -208,4 +212,39 @@ inline constexpr auto zip = []<class... T>(T&&... vs){
 ///
 args parse_args(int const argc, char const * const * const argv);
 
+///
+///@brief looks up a named argument and converts it to the requested type
+///
+///@param[in] t_args parsed arguments
+///@param[in] t_name name of the argument without the leading dashes
+///
+///@return the converted value, or nullopt if the argument is absent or
+/// given without a value, as in --name
+///@throws std::runtime_error if the value doesn't convert, so a typo never
+/// falls back to a default unnoticed
+///
+template<class T>
+std::optional<T> get_named(args const & t_args, std::string_view const t_name)
+{
+	auto const it = t_args.named.find(t_name);
+	if (it == t_args.named.end())
+		return std::nullopt;
+	if constexpr (std::is_same_v<T, std::string_view>)
+	{
+		return it->second;
+	}
+	else
+	{
+		T    value {};
+		auto const str = it->second;
+		if (str.empty())
+			return std::nullopt;
+		auto const [end, ec] =
+		    std::from_chars(str.data(), str.data() + str.size(), value);
+		if (ec != std::errc {} || end != str.data() + str.size())
+			throw std::runtime_error("--" + std::string(t_name) + " takes a number");
+		return value;
+	}
+}
+
 #endif // HELPER_HPP_INCLUDED
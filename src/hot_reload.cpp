@@ -0,0 +1,144 @@
+#include "hot_reload.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <system_error>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+pipeline_reloader::pipeline_reloader(std::filesystem::path t_root)
+    : m_root(std::move(t_root))
+    , m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+	if (m_inotify < 0)
+		throw std::system_error(errno, std::generic_category(), "inotify_init1");
+	try {
+		// inotify doesn't recurse, every pipeline's directory is watched on
+		// its own and the root for the ones created later
+		watch(m_root, {});
+		for (auto const & entry : std::filesystem::directory_iterator(m_root))
+			if (entry.is_directory())
+				watch(entry.path(), entry.path().filename().string());
+	} catch (...) {
+		close(m_inotify);
+		throw;
+	}
+}
+
+pipeline_reloader::~pipeline_reloader()
+{
+	m_stop = true;
+	if (m_thread.joinable())
+		m_thread.join();
+	close(m_inotify);
+}
+
+void
+pipeline_reloader::add(std::string t_pipeline, build_fn t_build)
+{
+	m_builders.insert_or_assign(std::move(t_pipeline), std::move(t_build));
+}
+
+void
+pipeline_reloader::start()
+{
+	m_thread = std::thread(&pipeline_reloader::run, this);
+}
+
+std::vector<std::pair<std::string, pipeline_reloader::pipeline_t>>
+pipeline_reloader::take_ready()
+{
+	std::lock_guard lock(m_mutex);
+	return std::exchange(m_ready, {});
+}
+
+void
+pipeline_reloader::watch(std::filesystem::path const & t_dir, std::string t_pipeline)
+{
+	auto const wd = inotify_add_watch(
+	    m_inotify, t_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if (wd < 0)
+		throw std::system_error(errno, std::generic_category(), t_dir.string());
+	m_watches.insert_or_assign(wd, std::move(t_pipeline));
+}
+
+bool
+pipeline_reloader::load(std::string const & t_pipeline, std::string_view t_spv)
+{
+	auto const file = t_spv.substr(0, t_spv.size() - 4);
+	if (!find_embedded_shader(t_pipeline, file)) {
+		std::clog << t_pipeline << '/' << file << " isn't built in, new stages need a rebuild\n";
+		return false;
+	}
+	auto const      path = m_root / t_pipeline / t_spv;
+	std::error_code ec;
+	auto const      size = std::filesystem::file_size(path, ec);
+	std::vector<std::uint32_t> code(ec ? 0 : size / sizeof(std::uint32_t));
+	std::ifstream in(path, std::ios::binary);
+	constexpr std::uint32_t spirv_magic = 0x07230203;
+	if (ec || size % sizeof(std::uint32_t) || code.size() < 5 || !in ||
+	    !in.read(reinterpret_cast<char *>(code.data()), static_cast<std::streamsize>(size)) ||
+	    code[0] != spirv_magic) {
+		std::clog << "could not load " << path << '\n';
+		return false;
+	}
+	m_overrides.set(t_pipeline, file, std::move(code));
+	return true;
+}
+
+void
+pipeline_reloader::run()
+{
+	alignas(inotify_event) char buffer[4096];
+	std::set<std::string>       dirty;
+	while (!m_stop) {
+		pollfd descriptor {.fd = m_inotify, .events = POLLIN, .revents = 0};
+		if (poll(&descriptor, 1, 100) <= 0) {
+			// a make run rewrites several files in a row, the pipelines are
+			// only built once things have been quiet for a moment
+			for (auto const & name : dirty) {
+				try {
+					auto pipeline = m_builders.find(name)->second(m_overrides);
+					std::lock_guard lock(m_mutex);
+					m_ready.emplace_back(name, std::move(pipeline));
+					std::clog << "reloaded " << name << '\n';
+				} catch (std::exception const & ex) {
+					std::clog << "could not rebuild " << name << ": " << ex.what() << '\n';
+				}
+			}
+			dirty.clear();
+			continue;
+		}
+		for (;;) {
+			auto const length = read(m_inotify, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+			for (auto const * p = buffer; p < buffer + length;) {
+				auto const & e = *reinterpret_cast<inotify_event const *>(p);
+				p += sizeof(inotify_event) + e.len;
+				auto const it = m_watches.find(e.wd);
+				if (it == m_watches.end() || !e.len)
+					continue;
+				std::string_view const name = e.name;
+				if (e.mask & IN_ISDIR) {
+					if (it->second.empty()) {
+						try {
+							watch(m_root / name, std::string(name));
+						} catch (std::exception const & ex) {
+							std::clog << "could not watch " << ex.what() << '\n';
+						}
+					}
+					continue;
+				}
+				if (it->second.empty() || !name.ends_with(".spv") ||
+				    !m_builders.contains(it->second))
+					continue;
+				if (load(it->second, name))
+					dirty.insert(it->second);
+			}
+		}
+	}
+}
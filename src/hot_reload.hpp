@@ -0,0 +1,79 @@
+#ifndef HOT_RELOAD_HPP_INCLUDED
+#define HOT_RELOAD_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "shaders.hpp"
+
+///
+///@brief rebuilds pipelines in the background when their compiled shaders
+/// change on disk
+///
+/// A thread watches <root>/<pipeline>/<file>.spv, where the makefile puts
+/// the compiled shaders, with inotify. When a shader of a registered
+/// pipeline is rewritten the thread loads it, rebuilds the pipeline with
+/// every shader loaded so far in place of the embedded ones and hands it
+/// over through take_ready(). The render loop swaps it in between frames,
+/// so it never waits for a compile. A shader that fails to load or a
+/// pipeline that fails to build is reported and the old one kept.
+///
+class pipeline_reloader{
+	public:
+	using pipeline_t = std::pair<vk::UniquePipeline, std::vector<vk::UniqueShaderModule>>;
+	///
+	///@brief builds the pipeline, called from the reloader's thread
+	///
+	using build_fn = std::function<pipeline_t(shader_overrides const &)>;
+
+	private:
+	std::filesystem::path                       m_root;
+	std::map<std::string, build_fn, std::less<>> m_builders;
+	shader_overrides                            m_overrides; // thread only
+	int                                         m_inotify = -1;
+	std::map<int, std::string>                  m_watches;   // directory per watch
+	std::mutex                                  m_mutex;
+	std::vector<std::pair<std::string, pipeline_t>> m_ready;
+	std::atomic<bool>                           m_stop {false};
+	std::thread                                 m_thread;
+
+	void watch(std::filesystem::path const & t_dir, std::string t_pipeline);
+	bool load(std::string const & t_pipeline, std::string_view t_spv);
+	void run();
+
+	public:
+	///
+	///@param[in] t_root directory the compiled shaders are in
+	///@throws std::runtime_error if it can't be watched
+	///
+	explicit pipeline_reloader(std::filesystem::path t_root);
+	pipeline_reloader(pipeline_reloader const &) = delete;
+	pipeline_reloader & operator=(pipeline_reloader const &) = delete;
+	~pipeline_reloader();
+
+	///
+	///@brief registers how to rebuild a pipeline, all of them have to be
+	/// added before start()
+	///
+	void add(std::string t_pipeline, build_fn t_build);
+
+	///
+	///@brief starts watching
+	///
+	void start();
+
+	///
+	///@return the pipelines rebuilt since the last call, by name
+	///
+	std::vector<std::pair<std::string, pipeline_t>> take_ready();
+};
+
+#endif // HOT_RELOAD_HPP_INCLUDED
@@ -16,162 +16,44 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <cmath>
+#include <thread>
+#include <mutex>
 #define SDL_MAIN_HANDLED
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_vulkan.h>
 #include "helper.hpp"
+#include "device.hpp"
+#include "debug_log.hpp"
+#include "present_options.hpp"
+#include "pacing.hpp"
+#include "trace.hpp"
+#include "hot_reload.hpp"
+#include "frame.hpp"
+#include "allocator.hpp"
+#include "offscreen.hpp"
+#include "stats.hpp"
+#include "gpu_timer.hpp"
+#include "pipeline_cache.hpp"
+#include "shaders.hpp"
+#include "upload.hpp"
+#include "mesh.hpp"
+#include "recorder.hpp"
+#include "culling.hpp"
+#include "particles.hpp"
+#include "timeline.hpp"
+#include "uniform_ring.hpp"
+#include "render_graph.hpp"
+#include "capture.hpp"
+#include "resolution.hpp"
+#include "mesh_file.hpp"
 
 namespace views = std::ranges::views;
 namespace ranges= std::ranges;
 
-static VKAPI_ATTR VkBool32 VKAPI_CALL
-dbcb(
-    VkDebugUtilsMessageSeverityFlagBitsEXT const       t_messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT const              t_messageType,
-    VkDebugUtilsMessengerCallbackDataEXT const * const t_pCallbackData,
-    [[maybe_unused]] void * const                      i)
-{
-    using dmt = vk::DebugUtilsMessageTypeFlagBitsEXT;
-    using dms = vk::DebugUtilsMessageSeverityFlagBitsEXT;
-	auto const messageSeverity = static_cast<dms>(t_messageSeverity);
-	auto const messageType     = static_cast<dmt>(t_messageType);
-	// auto * pCallbackData =
-	//	static_cast<vk::DebugUtilsMessengerCallbackDataEXT *>(t_pCallbackData);
-	auto const infobit  = messageSeverity & dms::eInfo;
-	auto const errorbit = messageSeverity & dms::eError;
-	auto const warnbit  = messageSeverity & dms::eWarning;
-	auto const verbbit  = messageSeverity & dms::eVerbose;
-	auto const genbit  = (messageType & dmt::eGeneral);
-	auto const perfbit = (messageType & dmt::ePerformance);
-	auto const valbit  = (messageType & dmt::eValidation);
-	std::cerr << "["
-        << (verbbit  ? 'V' : '-')
-        << (infobit  ? 'I' : '-')
-	    << (warnbit  ? 'W' : '-')
-        << (errorbit ? 'E' : '-')
-        << "]["
-	    << (genbit  ? 'G' : '-')
-        << (perfbit ? 'P' : '-')
-	    << (valbit  ? 'V' : '-')
-	    << "]validation layer: "
-        << t_pCallbackData->pMessage << std::endl;
-	return VK_FALSE;
-}
-
-struct queue_family {
-	std::uint32_t index;
-	std::uint32_t count;
-	bool graphics;
-	bool compute;
-	bool transfer;
-	bool sparse_binding;
-	bool protected_memory;
-};
-
-std::vector<queue_family>
-enumerate_queue_families(vk::PhysicalDevice const & t_d){
-	auto const families = t_d.getQueueFamilyProperties();
-	auto const numbers  = range(static_cast<std::uint32_t>(families.size()));
-	std::vector<queue_family> out;
-	out.reserve(families.size());
-	std::transform( families.begin(), families.end(), numbers.begin(),
-	    std::back_inserter(out),
-	    [](auto const & t_f, auto i) -> queue_family {
-            using qfb = vk::QueueFlagBits;
-		    return {
-		        i,
-		        t_f.queueCount,
-		        bool(t_f.queueFlags & qfb::eCompute),
-		        bool(t_f.queueFlags & qfb::eGraphics),
-		        bool(t_f.queueFlags & qfb::eTransfer),
-		        bool(t_f.queueFlags & qfb::eSparseBinding),
-		        bool(t_f.queueFlags & qfb::eProtected)};
-	    });
-	return out;
-};
-
-template<class InputIt>
-bool
-check_extension_support(
-    vk::PhysicalDevice const & t_dev, InputIt t_beg, InputIt t_end){
-	std::vector<char const *> sorted_extensions(
-	    static_cast<std::size_t>(std::distance(t_beg, t_end)));
-	std::partial_sort_copy( t_beg, t_end,
-	    sorted_extensions.begin(),
-	    sorted_extensions.end(),
-	    [](char const * a, char const * b) {
-		    return std::strcmp(a, b) < 0;
-	    });
-
-	std::vector<vk::ExtensionProperties> dev_extensions =
-	    t_dev.enumerateDeviceExtensionProperties();
-	std::sort(
-	    dev_extensions.begin(),
-	    dev_extensions.end(),
-	    [](auto const & a, auto const & b) {
-		    return std::strcmp(a.extensionName, b.extensionName) < 0;
-	    });
-	std::vector<char const *> dev_extensions_stripped(dev_extensions.size());
-	std::transform(
-	    dev_extensions.begin(),
-	    dev_extensions.end(),
-	    dev_extensions_stripped.begin(),
-	    [](auto const & a) {
-		    return a.extensionName.data();
-	    });
-	return std::includes(
-	    dev_extensions_stripped.begin(),
-	    dev_extensions_stripped.end(),
-	    sorted_extensions.begin(),
-	    sorted_extensions.end(),
-	    [](auto a, auto b) {
-		    return std::strcmp(a, b) < 0;
-	    });
-}
-
-struct pick_devce_and_queues_t{
-	vk::PhysicalDevice device;
-	queue_family       graphics;
-	queue_family       present;
-};
-
-template<class FwIt>
-pick_devce_and_queues_t
-pick_devce_and_queues(
-    vk::Instance const &   inst,
-    vk::SurfaceKHR const & window,
-    FwIt                   t_ext_begin,
-    FwIt                   t_ext_end)
-{
-	std::pair<vk::Device, std::vector<vk::Queue>> ret;
-	auto devices = inst.enumeratePhysicalDevices();
-	for (auto device : devices)
-	{
-		auto queues = enumerate_queue_families(device);
-		if (!check_extension_support(device, t_ext_begin, t_ext_end))
-			continue;
-		auto graphics_queue_info_it = std::find_if(
-		    queues.begin(),
-		    queues.end(),
-		    [&window = std::as_const(window)](queue_family const & a) {
-			    return a.graphics;
-		    });
-		auto present_queue_info_it = std::find_if(
-		    queues.begin(),
-		    queues.end(),
-		    [&window = std::as_const(window),
-		     &device = std::as_const(device)](queue_family const & a) {
-			    return device.getSurfaceSupportKHR(a.index, window);
-		    });
-		if (present_queue_info_it != queues.end() &&
-		    graphics_queue_info_it != queues.end())
-		{
-			return {device, *present_queue_info_it, *graphics_queue_info_it};
-		}
-	}
-	throw std::runtime_error("No suitable vulkan device");
-}
-
 template<class T, class FwIt1, class FwIt2>
 T choose_with_priority(
     FwIt1 const range_begin,
@@ -194,7 +76,9 @@ configure_swapchain(
     std::uint32_t                             t_array_layers,
     vk::PhysicalDevice const &                device,
     vk::SurfaceKHR const &                    surface,
-    SDL_Window *                              native_win) {
+    SDL_Window *                              native_win,
+    vk::SwapchainKHR const &                  t_old_swapchain,
+    vk::ImageUsageFlags                       t_usage = vk::ImageUsageFlagBits::eColorAttachment) {
 	// get what's avaliavble in our graphics device
 	auto avaliable_capabilities = device.getSurfaceCapabilitiesKHR(surface);
 	auto avaliable_formats      = device.getSurfaceFormatsKHR(surface);
@@ -203,6 +87,9 @@ configure_swapchain(
 		throw std::runtime_error(
 		    "swapchain inadequate"); // we cannot create the swapchain if
 		                             // there's no options to choose from
+	if ((avaliable_capabilities.supportedUsageFlags & t_usage) != t_usage)
+		throw std::runtime_error(
+		    "swapchain images can't be used as " + vk::to_string(t_usage));
 
 	// get SDL's opinion on window size
 	std::tuple<std::uint32_t, std::uint32_t> native_win_surface_size;
@@ -248,7 +135,7 @@ configure_swapchain(
 	    .imageColorSpace  = image_format.colorSpace,
 	    .imageExtent      = image_size,
 	    .imageArrayLayers = t_array_layers,
-	    .imageUsage       = vk::ImageUsageFlagBits::eColorAttachment,
+	    .imageUsage       = t_usage,
 	    .compositeAlpha =
 	        (composite_alpha & avaliable_capabilities.supportedCompositeAlpha) ?
             composite_alpha :
@@ -258,124 +145,271 @@ configure_swapchain(
 	        avaliable_modes.end(),
 	        t_preferred_present_modes.begin(),
 	        t_preferred_present_modes.end(),
-	        vk::PresentModeKHR::eImmediate),
+	        vk::PresentModeKHR::eFifo), // the only one that's always there
 	    .clipped = true,
+	    .oldSwapchain = t_old_swapchain,
 	};
 }
 
 vk::UniqueShaderModule
-create_shader_module(vk::Device const & t_d, std::filesystem::path t_path_to_the_shader){
-	std::ifstream shader_contents(t_path_to_the_shader, std::ios::binary);
-	if (!shader_contents.is_open()) throw std::runtime_error("could not find the shader by path");
-	shader_contents.seekg(0, std::ios::end);
-	std::vector<std::uint32_t> spirv_data(
-	    static_cast<std::size_t>(shader_contents.tellg()) /
-	    sizeof(decltype(spirv_data)::value_type));
-	shader_contents.seekg(std::ios::beg);
-
-	shader_contents.read(
-	    reinterpret_cast<char *>(spirv_data.data()),
-	    static_cast<std::streamoff>(
-	        spirv_data.size() * sizeof(decltype(spirv_data)::value_type)));
+create_shader_module(vk::Device const & t_d, std::span<std::uint32_t const> t_spirv){
 	return t_d.createShaderModuleUnique(
-	    {.codeSize = spirv_data.size() * 4, .pCode = spirv_data.data()});
+	    {.codeSize = t_spirv.size_bytes(), .pCode = t_spirv.data()});
 }
 
 
 std::pair<vk::UniquePipeline, std::vector<vk::UniqueShaderModule>>
 make_graphics_pipeline(
     vk::Device const &             t_dev,
+    vk::PipelineCache const &      t_cache,
     std::string_view               t_pipeline_name,
-    vk::GraphicsPipelineCreateInfo t_info) {
-	namespace fs = std::filesystem;
-	auto const path_to_shaders =
-	    fs::current_path() / "build" / "shaders" / t_pipeline_name;
-	if (!fs::exists(path_to_shaders))
-		throw std::runtime_error("no shader path");
-
-    using stage = vk::ShaderStageFlagBits;
+    vk::GraphicsPipelineCreateInfo t_info,
+    shader_overrides const *       t_overrides = nullptr) {
+	trace_scope const scope("make_graphics_pipeline");
+	// the shaders are compiled into the binary, every embedded shader
+	// under shaders/<pipeline name>/ becomes a stage of the pipeline, with
+	// the code that was reloaded since if there's any
 	std::vector<vk::PipelineShaderStageCreateInfo> stages;
     std::vector<vk::UniqueShaderModule> modules;
-    modules.push_back(create_shader_module(t_dev, path_to_shaders / "main.vert.spv"));
-    modules.push_back(create_shader_module(t_dev, path_to_shaders / "main.frag.spv"));
 	stages.reserve(5); // it's the maximum number of stages iirc
-        stages.push_back({
-            .stage = stage::eVertex,
-            .module = *(modules[0]),
-            .pName  = "main",
-        });
-        stages.push_back({
-            .stage = stage::eFragment,
-            .module = *(modules[1]),
-            .pName  = "main",
-        });
+	for (auto const & shader : embedded_shaders()) {
+		if (shader.pipeline != t_pipeline_name)
+			continue;
+		modules.push_back(create_shader_module(
+		    t_dev, t_overrides ? t_overrides->code(shader) : shader.code));
+		stages.push_back({
+		    .stage  = shader.stage,
+		    .module = *modules.back(),
+		    .pName  = "main",
+		});
+	}
+	if (stages.empty())
+		throw std::runtime_error("no shaders for the pipeline");
 	t_info.stageCount = static_cast<std::uint32_t>(stages.size());
 	t_info.pStages    = stages.data();
-	return {t_dev.createGraphicsPipelineUnique({}, t_info).value, std::move(modules)};
+	return {t_dev.createGraphicsPipelineUnique(t_cache, t_info).value, std::move(modules)};
+}
+
+///
+///@brief placement of the t_index-th of t_count copies of the mesh, laid
+/// out in a square grid filling the viewport
+///
+draw_item
+grid_cell(std::size_t t_index, std::size_t t_count){
+	auto const side = std::max<std::size_t>(
+	    static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(t_count)))), 1);
+	auto const cell = 2.0f / static_cast<float>(side);
+	return {
+	    .offset = {
+	        -1.0f + cell * (static_cast<float>(t_index % side) + 0.5f),
+	        -1.0f + cell * (static_cast<float>(t_index / side) + 0.5f),
+	    },
+	    .scale = cell / 2.0f,
+	};
+}
+
+std::vector<draw_item>
+grid_draws(std::size_t t_count){
+	std::vector<draw_item> out;
+	out.reserve(t_count);
+	for (std::size_t i = 0; i < t_count; ++i)
+		out.push_back(grid_cell(i, t_count));
+	return out;
+}
+
+std::vector<instance>
+grid_instances(std::size_t t_count){
+	std::vector<instance> out;
+	out.reserve(t_count);
+	for (std::size_t i = 0; i < t_count; ++i) {
+		auto const cell = grid_cell(i, t_count);
+		// the first instance keeps the mesh's own colours, the rest are
+		// tinted so neighbours can be told apart
+		auto const hue = static_cast<float>(i) * 2.4f;
+		out.push_back({
+		    .offset = cell.offset,
+		    .scale  = cell.scale,
+		    .color  = i == 0 ? std::array {1.0f, 1.0f, 1.0f} : std::array {
+		        0.5f + 0.5f * std::cos(hue),
+		        0.5f + 0.5f * std::cos(hue + 2.1f),
+		        0.5f + 0.5f * std::cos(hue + 4.2f),
+		    },
+		});
+	}
+	return out;
+}
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void
+on_interrupt(int)
+{
+	interrupted = 1;
 }
 
 int
 main(int argc, char const * const * argv){
-	SDL_SetMainReady();
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		throw std::runtime_error(SDL_GetError());
+	auto const startup_start = std::chrono::steady_clock::now();
 	auto const args = parse_args(argc, argv);
+	// --trace[=<file>] writes the markers of the startup phases and every
+	// frame as a Chrome trace when main returns, trace.json by default
+	std::optional<trace_session> tracing;
+	if (auto const trace_path = get_named<std::string_view>(args, "trace"))
+		tracing.emplace(trace_path->empty() ? "trace.json" : *trace_path);
+	trace_scope startup_scope("startup");
+	// --convert-obj=<file> writes the obj as a mesh file for --mesh, next to
+	// it or to --mesh-out=<file>
+	if (auto const obj_path = get_named<std::string_view>(args, "convert-obj")) {
+		std::ifstream in{std::filesystem::path(*obj_path)};
+		if (!in)
+			throw std::runtime_error("could not open " + std::string(*obj_path));
+		auto const mesh_out  = get_named<std::string_view>(args, "mesh-out");
+		auto const mesh_path = mesh_out ? std::filesystem::path(*mesh_out)
+		                                : std::filesystem::path(*obj_path).replace_extension(".mesh");
+		auto const mesh = parse_obj(in);
+		write_mesh_file(mesh_path, mesh);
+		std::cout << mesh_path.string() << ": " << mesh.vertices.size() << " vertices, "
+		          << mesh.indices.size() / 3 << " triangles\n";
+		return 0;
+	}
+	// --mesh-bench=<file> compares loading a mesh file mapped and read onto
+	// the heap, and parsing --mesh-bench-obj=<file> if given
+	if (auto const bench_path = get_named<std::string_view>(args, "mesh-bench")) {
+		std::optional<std::filesystem::path> obj_path;
+		if (auto const obj = get_named<std::string_view>(args, "mesh-bench-obj"))
+			obj_path = *obj;
+		benchmark_mesh_load(*bench_path, obj_path, std::cout);
+		return 0;
+	}
+	// --headless renders into offscreen images, no window, surface or swapchain
+	auto const headless = args.named.contains("headless");
+	std::signal(SIGINT, on_interrupt);
+	std::signal(SIGTERM, on_interrupt);
 
-	auto sdl_window = SDL_CreateWindow(
-	    "TEST", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1000, 1000,
-	    SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+	// destroys the window on every way out of main, after the surface
+	std::unique_ptr<SDL_Window, decltype(&SDL_DestroyWindow)> window_guard(
+	    nullptr, SDL_DestroyWindow);
+	SDL_Window * sdl_window = nullptr;
+	if (!headless)
+	{
+		SDL_SetMainReady();
+		trace_scope sdl_scope("SDL_Init");
+		if (SDL_Init(SDL_INIT_VIDEO) != 0)
+			throw std::runtime_error(SDL_GetError());
+		sdl_scope.end();
+		sdl_window = SDL_CreateWindow(
+		    "TEST", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1000, 1000,
+		    SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
 
-	if (!sdl_window)
-		throw std::runtime_error(std::string("no window: ") + SDL_GetError());
+		if (!sdl_window)
+			throw std::runtime_error(std::string("no window: ") + SDL_GetError());
+		window_guard.reset(sdl_window);
+	}
 
-	static std::array<char const *, 1> const inst_layers {
-	    "VK_LAYER_KHRONOS_validation",
-        //"VK_LAYER_LUNARG_standard_validation",
-	};
+	// --validation=<off|error|warning|info|verbose> enables the validation
+	// layer and reports messages of that severity and up, warning by default
+	auto const validation_name = get_named<std::string_view>(args, "validation").value_or("warning");
+	auto const validation_severities = parse_severity(validation_name);
+	if (!validation_severities && validation_name != "off")
+		throw std::runtime_error("--validation takes off, error, warning, info or verbose");
+	std::vector<char const *> inst_layers;
+	if (validation_severities) {
+		auto const available = vk::enumerateInstanceLayerProperties();
+		if (std::any_of(available.begin(), available.end(), [](auto const & t_layer) {
+			    return std::string_view(t_layer.layerName.data()) == "VK_LAYER_KHRONOS_validation";
+		    }))
+			inst_layers.push_back("VK_LAYER_KHRONOS_validation");
+		else
+			std::cerr << "VK_LAYER_KHRONOS_validation isn't installed, running without it\n";
+	}
 	static std::array<char const *, 0> const dev_layers {};
-	static std::array<char const *, 1> const dev_extensions {
-	    "VK_KHR_swapchain",
-	};
+	// the log outlives the instance, which may still report while it's
+	// destroyed
+	std::optional<debug_log> validation_log;
+	if (!inst_layers.empty())
+		validation_log.emplace(std::cerr);
+	std::vector<char const *> dev_extensions;
+	if (!headless)
+		dev_extensions.push_back("VK_KHR_swapchain");
 	{
+		// Vulkan 1.2 brings timeline semaphores and the feature queries the
+		// present wait needs, a 1.0 loader doesn't even know how to tell its
+		// version. --no-timeline sticks to fences on purpose
+		std::uint32_t instance_version = VK_API_VERSION_1_0;
+		if (auto const enumerate_version = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+		        vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion")))
+			enumerate_version(&instance_version);
+		auto const vulkan_12      = instance_version >= VK_API_VERSION_1_2;
+		auto const want_timelines = vulkan_12 && !args.named.contains("no-timeline");
 		vk::ApplicationInfo const info {
 		    .pApplicationName   = "Hello triangle",
 		    .applicationVersion = 1,
 		    .pEngineName        = "None",
 		    .engineVersion      = 1,
-		    .apiVersion         = VK_API_VERSION_1_0};
-        using dsf = vk::DebugUtilsMessageSeverityFlagBitsEXT;
-        using dmt = vk::DebugUtilsMessageTypeFlagBitsEXT;
-		vk::DebugUtilsMessengerCreateInfoEXT debug_info {
-		    .messageSeverity = dsf::eError | dsf::eWarning | dsf::eInfo | dsf::eVerbose,
-		    .messageType = dmt::eGeneral | dmt::ePerformance | dmt::eValidation,
-		    .pfnUserCallback = dbcb,
-		};
+		    .apiVersion         = vulkan_12 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0};
+		vk::DebugUtilsMessengerCreateInfoEXT debug_info {};
+		if (validation_log)
+			debug_info = validation_log->messenger_info(*validation_severities);
 		std::uint32_t ext_count = 0;
-		SDL_Vulkan_GetInstanceExtensions(sdl_window, &ext_count, nullptr);
-		std::vector<char const *> inst_extensions(ext_count);
-		SDL_Vulkan_GetInstanceExtensions(
-		    sdl_window,
-		    &ext_count,
-		    inst_extensions.data());
+		std::vector<char const *> inst_extensions;
+		if (sdl_window)
+		{
+			SDL_Vulkan_GetInstanceExtensions(sdl_window, &ext_count, nullptr);
+			inst_extensions.resize(ext_count);
+			SDL_Vulkan_GetInstanceExtensions(
+			    sdl_window,
+			    &ext_count,
+			    inst_extensions.data());
+		}
+		if (validation_log)
+			inst_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 		vk::InstanceCreateInfo inst_info {
-		    .pNext             = static_cast<void *>(&debug_info),
+		    .pNext             = validation_log ? static_cast<void *>(&debug_info) : nullptr,
 		    .pApplicationInfo  = &info,
 		    .enabledLayerCount = static_cast<std::uint32_t>(inst_layers.size()),
 		    .ppEnabledLayerNames     = inst_layers.data(),
-		    .enabledExtensionCount   = ext_count,
+		    .enabledExtensionCount   = static_cast<std::uint32_t>(inst_extensions.size()),
 		    .ppEnabledExtensionNames = inst_extensions.data(),
 		};
+		trace_scope instance_scope("createInstanceUnique");
 		auto inst = vk::createInstanceUnique(inst_info);
+		instance_scope.end();
 		auto window = [&]{
+			if (!sdl_window)
+				return vk::UniqueSurfaceKHR{};
 			VkSurfaceKHR native_win;
 			SDL_Vulkan_CreateSurface(sdl_window, *inst, &native_win);
 			return vk::UniqueSurfaceKHR{native_win, vk::ObjectDestroy<vk::Instance, vk::DispatchLoaderStatic>(*inst)};
 		}();
 
-		auto queues = pick_devce_and_queues( *inst, *window, dev_extensions.begin(), dev_extensions.end());
-		vk::PhysicalDeviceFeatures             f {};
+		// every device is rated once, --list-devices prints the ratings and
+		// --device=<index|name> overrides the best rated one
+		trace_scope rate_scope("rate_devices");
+		auto const devices = rate_devices(*inst, *window, dev_extensions);
+		rate_scope.end();
+		if (args.named.contains("list-devices")) {
+			print_device_reports(std::cout, devices);
+			return 0;
+		}
+		auto const & chosen_device = devices[choose_device(devices, get_named<std::string_view>(args, "device"))];
+		std::cout << "using " << chosen_device.properties.deviceName.data() << '\n';
+		auto queues = pick_devce_and_queues(chosen_device);
+		// --no-transfer-queue uploads through the graphics queue instead
+		if (args.named.contains("no-transfer-queue"))
+			queues.transfer.reset();
+		// --no-async-compute runs compute work on the graphics queue instead
+		if (args.named.contains("no-async-compute"))
+			queues.compute.reset();
+		// --cull culls the instances in a compute pass and draws them
+		// indirectly, which needs a couple of device features
+		auto const cull = args.named.contains("cull");
+		if (cull && !gpu_culler::supported(queues.device, 0))
+			throw std::runtime_error("--cull needs multiDrawIndirect and drawIndirectFirstInstance");
+		vk::PhysicalDeviceFeatures             f = cull ? gpu_culler::required_features() : vk::PhysicalDeviceFeatures {};
 		std::vector<float>                     queue_priorities_graphics {1};
 		std::vector<float>                     queue_priorities_present {1};
+		std::vector<float>                     queue_priorities_transfer {1};
+		std::vector<float>                     queue_priorities_compute {1};
 		std::vector<vk::DeviceQueueCreateInfo> queue_info {
 		    {
                 .queueFamilyIndex = static_cast<std::uint32_t>(queues.graphics.index),
@@ -387,87 +421,244 @@ main(int argc, char const * const * argv){
 		        .pQueuePriorities = queue_priorities_present.data()
             },
 		};
-		queue_info.erase(std::unique(
+		if (queues.transfer)
+			queue_info.push_back({
+			    .queueFamilyIndex = queues.transfer->index,
+			    .queueCount = static_cast<std::uint32_t>(queue_priorities_transfer.size()),
+			    .pQueuePriorities = queue_priorities_transfer.data()
+			});
+		if (queues.compute)
+			queue_info.push_back({
+			    .queueFamilyIndex = queues.compute->index,
+			    .queueCount = static_cast<std::uint32_t>(queue_priorities_compute.size()),
+			    .pQueuePriorities = queue_priorities_compute.data()
+			});
+		std::sort(
 		    std::begin(queue_info),
 		    std::end(queue_info),
 		    [](vk::DeviceQueueCreateInfo const & a,
 		       vk::DeviceQueueCreateInfo const & b) {
-			    return a.queueFamilyIndex == b.queueFamilyIndex;
-		    }));
+			    return a.queueFamilyIndex < b.queueFamilyIndex;
+		    });
+		queue_info.erase(
+		    std::unique(
+		        std::begin(queue_info),
+		        std::end(queue_info),
+		        [](vk::DeviceQueueCreateInfo const & a,
+		           vk::DeviceQueueCreateInfo const & b) {
+			        return a.queueFamilyIndex == b.queueFamilyIndex;
+		        }),
+		    std::end(queue_info));
+
+		// timeline semaphores when the device has them as well, and the
+		// culled draw reads its count on the gpu
+		auto const device_12 = vulkan_12 && queues.device.getProperties().apiVersion >= VK_API_VERSION_1_2;
+		vk::PhysicalDeviceVulkan12Features features_12 {};
+		if (device_12 && (want_timelines || cull)) {
+			auto const supported_12 =
+			    queues.device
+			        .getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>()
+			        .get<vk::PhysicalDeviceVulkan12Features>();
+			features_12.drawIndirectCount = cull && supported_12.drawIndirectCount;
+			features_12.timelineSemaphore = want_timelines && supported_12.timelineSemaphore;
+		}
+		auto const timelines  = static_cast<bool>(features_12.timelineSemaphore);
+		auto const draw_count = static_cast<bool>(features_12.drawIndirectCount);
+		// --latency measures how long frames take from the event poll to the
+		// display, the last step needs VK_KHR_present_wait
+		auto const latency = args.named.contains("latency");
+		vk::PhysicalDevicePresentIdFeaturesKHR   present_id_features {};
+		vk::PhysicalDevicePresentWaitFeaturesKHR present_wait_features {};
+		if (latency && device_12 && !headless &&
+		    check_extension_support(queues.device, present_latency::required_extensions())) {
+			auto const chain = queues.device.getFeatures2<
+			    vk::PhysicalDeviceFeatures2,
+			    vk::PhysicalDevicePresentIdFeaturesKHR,
+			    vk::PhysicalDevicePresentWaitFeaturesKHR>();
+			present_id_features.presentId     = chain.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId;
+			present_wait_features.presentWait = chain.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+		}
+		auto const present_wait = present_id_features.presentId && present_wait_features.presentWait;
+		if (latency && !present_wait)
+			std::clog << "no present wait, latency is measured up to the present call\n";
+		void * device_features = nullptr;
+		if (timelines || draw_count) {
+			features_12.pNext = device_features;
+			device_features   = &features_12;
+		}
+		if (present_wait) {
+			for (auto const * extension : present_latency::required_extensions())
+				dev_extensions.push_back(extension);
+			present_wait_features.pNext = device_features;
+			present_id_features.pNext   = &present_wait_features;
+			device_features             = &present_id_features;
+		}
 
+		trace_scope device_scope("createDeviceUnique");
 		auto logic_dev = queues.device.createDeviceUnique( {
+		        .pNext = device_features,
 		        .queueCreateInfoCount =
 		            static_cast<std::uint32_t>(queue_info.size()),
 		        .pQueueCreateInfos = queue_info.data(),
 		        .enabledLayerCount =
 		            static_cast<std::uint32_t>(dev_layers.size()),
 		        .ppEnabledLayerNames     = dev_layers.data(),
-		        .enabledExtensionCount   = dev_extensions.size(),
+		        .enabledExtensionCount   = static_cast<std::uint32_t>(dev_extensions.size()),
 		        .ppEnabledExtensionNames = dev_extensions.data(),
 		        .pEnabledFeatures        = &f,
 		    },
 		    nullptr);
+		device_scope.end();
+
+		// --alloc-bench compares the sub-allocator against raw allocations
+		if (args.named.contains("alloc-bench")) {
+			benchmark_allocator(queues.device, *logic_dev, std::cout);
+			return 0;
+		}
+		device_allocator allocator(queues.device, *logic_dev);
 
 		[[maybe_unused]] auto queue_present = logic_dev->getQueue(queues.present.index, 0);
 		[[maybe_unused]] auto queue_graphics = logic_dev->getQueue(queues.graphics.index, 0);
 
-		auto swapchain_info = configure_swapchain( {}, {vk::PresentModeKHR::eImmediate}, 3, 1, queues.device, *window, sdl_window);
-        if (queues.graphics.index != queues.present.index) {
-			swapchain_info.imageSharingMode      = vk::SharingMode::eConcurrent;
-			swapchain_info.queueFamilyIndexCount = 2;
-			static auto queue_family_indices     = {
-                queues.graphics.index,
-                queues.present.index,
-            };
-			swapchain_info.pQueueFamilyIndices = &*queue_family_indices.begin();
+		// every queue submitted to gets a timeline, uploads through the
+		// graphics queue count on the graphics one
+		std::optional<queue_timeline> graphics_timeline;
+		std::optional<queue_timeline> transfer_timeline;
+		std::optional<queue_timeline> compute_timeline;
+		if (timelines) {
+			graphics_timeline.emplace(*logic_dev);
+			if (queues.transfer)
+				transfer_timeline.emplace(*logic_dev);
+			if (queues.compute)
+				compute_timeline.emplace(*logic_dev);
+		}
+		auto const timeline_of = [](std::optional<queue_timeline> & t_timeline) {
+			return t_timeline ? &*t_timeline : nullptr;
+		};
+
+		// --staging-size=<bytes> sizes the ring uploads are staged through
+		auto const transfer_family = queues.transfer ? queues.transfer->index : queues.graphics.index;
+		uploader uploads(
+		    allocator,
+		    *logic_dev,
+		    {
+		        .transfer        = logic_dev->getQueue(transfer_family, 0),
+		        .transfer_family = transfer_family,
+		        .graphics        = queue_graphics,
+		        .graphics_family = queues.graphics.index,
+		        .transfer_timeline =
+		            timeline_of(queues.transfer ? transfer_timeline : graphics_timeline),
+		        .graphics_timeline = timeline_of(graphics_timeline),
+		    },
+		    get_named<vk::DeviceSize>(args, "staging-size").value_or(8 << 20));
+		// --mesh=<file> draws a mesh file instead of the triangle, mapped and
+		// copied from the mapping straight into the staging ring
+		std::optional<mapped_mesh> mesh_file;
+		auto const mesh_start = std::chrono::steady_clock::now();
+		if (auto const mesh_path = get_named<std::string_view>(args, "mesh"))
+			mesh_file.emplace(*mesh_path);
+		auto const mesh_vertices = mesh_file ? mesh_file->vertex_bytes() : std::as_bytes(std::span(triangle_vertices));
+		auto const mesh_indices  = mesh_file ? mesh_file->index_bytes() : std::as_bytes(std::span(triangle_indices));
+		auto const index_type    = mesh_file ? mesh_file->index_type() : vk::IndexType::eUint16;
+		auto const index_count   = mesh_file ? mesh_file->index_count() : static_cast<std::uint32_t>(triangle_indices.size());
+		auto const mesh_bounds   = mesh_radius(mesh_file ? mesh_file->vertices() : std::span<vertex const>(triangle_vertices));
+		auto vertex_buffer = logic_dev->createBufferUnique({
+		    .size        = mesh_vertices.size(),
+		    .usage       = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		    .sharingMode = vk::SharingMode::eExclusive,
+		});
+		auto const vertex_memory = allocator.bind(*vertex_buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		auto index_buffer = logic_dev->createBufferUnique({
+		    .size        = mesh_indices.size(),
+		    .usage       = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		    .sharingMode = vk::SharingMode::eExclusive,
+		});
+		auto const index_memory = allocator.bind(*index_buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		uploads.upload(
+		    *vertex_buffer, 0, mesh_vertices,
+		    vk::AccessFlagBits::eVertexAttributeRead, vk::PipelineStageFlagBits::eVertexInput);
+		uploads.upload(
+		    *index_buffer, 0, mesh_indices,
+		    vk::AccessFlagBits::eIndexRead, vk::PipelineStageFlagBits::eVertexInput);
+		// the copies run while the pipeline and the swapchain are set up
+		auto const geometry_ticket = uploads.flush();
+		if (mesh_file) {
+			// the data is in the staging ring already, the mapping can go
+			std::chrono::duration<double> const mesh_time = std::chrono::steady_clock::now() - mesh_start;
+			std::clog << "mesh: " << mesh_file->vertex_count() << " vertices, " << index_count / 3
+			          << " triangles, " << mesh_file->size() << " bytes mapped and staged in "
+			          << mesh_time.count() * 1000 << " ms, "
+			          << static_cast<double>(mesh_file->size()) / mesh_time.count() / 1e9 << " GB/s\n";
+			mesh_file.reset();
+		}
+
+		// the format is fixed for the lifetime of the render pass, only the
+		// resources depending on the extent are rebuilt with the swapchain
+		// --present-mode, --image-count, --surface-format and
+		// --frames-in-flight tune latency against throughput
+		auto const present = parse_present_options(args);
+		// --capture[=<dir>] copies every frame back and writes it to dir,
+		// build/capture by default, as --capture-format=<ppm|raw> files
+		auto const capture_dir = get_named<std::string_view>(args, "capture");
+		auto const capture_format_name =
+		    get_named<std::string_view>(args, "capture-format").value_or("ppm");
+		auto const capture_file_format = parse_capture_format(capture_format_name);
+		if (!capture_file_format)
+			throw std::runtime_error(
+			    "unknown --capture-format " + std::string(capture_format_name));
+		// --resolution-budget=<ms> renders the scene at the scale that keeps
+		// its gpu time within the budget, down to --min-resolution of each
+		// side, and blits it up to the target
+		std::optional<resolution_controller> scaler;
+		if (auto const budget = get_named<double>(args, "resolution-budget"))
+			scaler.emplace(
+			    *budget,
+			    get_named<float>(args, "min-resolution").value_or(0.5f),
+			    present.image_count + present.frames_in_flight);
+		auto target_usage = vk::ImageUsageFlags(vk::ImageUsageFlagBits::eColorAttachment);
+		if (capture_dir)
+			target_usage |= vk::ImageUsageFlagBits::eTransferSrc;
+		if (scaler)
+			target_usage |= vk::ImageUsageFlagBits::eTransferDst;
+		vk::Format         target_format;
+		vk::ColorSpaceKHR  target_color_space = vk::ColorSpaceKHR::eSrgbNonlinear;
+		vk::ImageLayout    target_layout;
+		vk::PresentModeKHR target_present_mode = vk::PresentModeKHR::eImmediate;
+		if (headless) {
+			target_format = vk::Format::eR8G8B8A8Unorm;
+			target_layout = vk::ImageLayout::eTransferSrcOptimal;
+		} else {
+			auto const swapchain_info = configure_swapchain( present.formats, present.present_modes, present.image_count, 1, queues.device, *window, sdl_window, {}, target_usage);
+			target_format       = swapchain_info.imageFormat;
+			target_color_space  = swapchain_info.imageColorSpace;
+			target_layout       = vk::ImageLayout::ePresentSrcKHR;
+			target_present_mode = swapchain_info.presentMode;
 		}
-		auto swapchain = logic_dev->createSwapchainKHRUnique(swapchain_info);
-        
-		auto swapchain_images = logic_dev->getSwapchainImagesKHR(*swapchain);
-		std::vector<vk::UniqueImageView> swapchain_image_views;
-		swapchain_image_views.reserve(swapchain_images.size());
-		for (auto const & image:swapchain_images) {
-            using cs = vk::ComponentSwizzle;
-            swapchain_image_views.push_back(
-                logic_dev->createImageViewUnique({
-                    .image    = image,
-                    .viewType = vk::ImageViewType::e2D,
-                    .format   = swapchain_info.imageFormat,
-                    .components = { .r = cs::eIdentity, .g = cs::eIdentity, .b = cs::eIdentity, .a = cs::eIdentity, },
-                    .subresourceRange = {
-                            .aspectMask     = vk::ImageAspectFlagBits::eColor,
-                            .baseMipLevel   = 0,
-                            .levelCount     = 1,
-                            .baseArrayLayer = 0,
-                            .layerCount     = 1,
-                        },
-                })
-            );
-        }
 
 		vk::PipelineVertexInputStateCreateInfo vertexinput_info = {
-		    .vertexBindingDescriptionCount   = 0,
-		    .vertexAttributeDescriptionCount = 0,
+		    .vertexBindingDescriptionCount   = static_cast<std::uint32_t>(vertex_bindings.size()),
+		    .pVertexBindingDescriptions      = vertex_bindings.data(),
+		    .vertexAttributeDescriptionCount = static_cast<std::uint32_t>(vertex_attributes.size()),
+		    .pVertexAttributeDescriptions    = vertex_attributes.data(),
 		};
 		vk::PipelineInputAssemblyStateCreateInfo inputassembly_info = {
 		    .topology               = vk::PrimitiveTopology::eTriangleList,
 		    .primitiveRestartEnable = false,
 		};
-		vk::Viewport viewport_info = {
-		    .x      = 0,
-		    .y      = 0,
-		    .width  = static_cast<float>(swapchain_info.imageExtent.width),
-		    .height = static_cast<float>(swapchain_info.imageExtent.height),
-		};
-		vk::Rect2D scissor_info = {
-		    .offset = {0, 0},
-		    .extent = {1, 1},
-		};
+		// viewport and scissor are dynamic, so a resize doesn't touch the pipeline
 		vk::PipelineViewportStateCreateInfo viewportstate_info = {
 		    .viewportCount = 1,
-		    .pViewports    = &viewport_info,
+		    .pViewports    = nullptr,
 		    .scissorCount  = 1,
-		    .pScissors     = &scissor_info,
+		    .pScissors     = nullptr,
+		};
+		std::array const dynamic_states {
+		    vk::DynamicState::eViewport,
+		    vk::DynamicState::eScissor,
+		};
+		vk::PipelineDynamicStateCreateInfo dynamicstate_info = {
+		    .dynamicStateCount = static_cast<std::uint32_t>(dynamic_states.size()),
+		    .pDynamicStates    = dynamic_states.data(),
 		};
 		vk::PipelineRasterizationStateCreateInfo rasterizationrtate_info = {
 		    .rasterizerDiscardEnable = false,
@@ -493,48 +684,57 @@ main(int argc, char const * const * argv){
 		    .pAttachments    = &noblend_attachment,
 		};
 
-        vk::PipelineLayoutCreateInfo pipeline_layout_info{};
-        auto pipeline_layout = logic_dev->createPipelineLayoutUnique(pipeline_layout_info);
-
-        using al = vk::AttachmentLoadOp;
-        using as = vk::AttachmentStoreOp;
-        using imglayout = vk::ImageLayout;
-        vk::AttachmentDescription color_attachment{
-            .format  = swapchain_info.imageFormat,
-            .samples = vk::SampleCountFlagBits::e1,
-            .loadOp  = al::eClear,
-            .storeOp = as::eStore,
-            .stencilLoadOp = al::eLoad,
-            .stencilStoreOp = as::eStore,
-            .initialLayout = imglayout::eUndefined,
-            .finalLayout = imglayout::ePresentSrcKHR,
-        };
-        vk::AttachmentReference attach_ref{
-            .attachment = 0,
-            .layout = imglayout::eColorAttachmentOptimal,
+        vk::PushConstantRange const draw_constants{
+            .stageFlags = vk::ShaderStageFlagBits::eVertex,
+            .offset     = 0,
+            .size       = sizeof(draw_item),
         };
-        vk::SubpassDescription sd{
-            .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
-            .colorAttachmentCount = 1,
-            .pColorAttachments = &attach_ref,
+        // per frame data of the vertex stage, a slot of the ring per frame
+        // in flight
+        uniform_ring frame_ring(
+            allocator,
+            queues.device,
+            *logic_dev,
+            present.frames_in_flight,
+            sizeof(frame_uniforms),
+            sizeof(frame_uniforms),
+            vk::ShaderStageFlagBits::eVertex);
+        auto const frame_set_layout = frame_ring.set_layout();
+        vk::PipelineLayoutCreateInfo pipeline_layout_info{
+            .setLayoutCount         = 1,
+            .pSetLayouts            = &frame_set_layout,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges    = &draw_constants,
         };
-        vk::SubpassDependency dep{
-            .srcSubpass = VK_SUBPASS_EXTERNAL,
-            .dstSubpass = 0,
-            .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-            .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-            .srcAccessMask = {},
-            .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
-        };
-        vk::RenderPassCreateInfo rp_info{
-            .attachmentCount = 1,
-            .pAttachments    = &color_attachment,
-            .subpassCount = 1,
-            .pSubpasses = &sd,
-            .dependencyCount = 1,
-            .pDependencies = &dep,
-        };
-        auto render_pass = logic_dev->createRenderPassUnique(rp_info);
+        auto pipeline_layout = logic_dev->createPipelineLayoutUnique(pipeline_layout_info);
+
+        // the passes only declare their attachments, the graph derives the
+        // render pass, its load and store ops and dependencies from them
+        // with dynamic resolution the scene goes to a scaled image instead
+        // of the target and is blitted from there
+        render_graph graph;
+        auto const color_target = graph.import_image(
+            scaler ? "scaled" : "target",
+            target_format,
+            vk::ImageLayout::eUndefined,
+            scaler ? vk::ImageLayout::eTransferSrcOptimal : target_layout,
+            vk::ClearValue{});
+        auto const scene_pass = graph.add_pass({
+            .name   = "scene",
+            .colors = {color_target},
+            .inputs = {},
+            .depth  = std::nullopt,
+        });
+        graph.compile(*logic_dev);
+        // --print-graph shows what the graph compiled into
+        if (args.named.contains("print-graph"))
+            graph.print(std::cout);
+        auto const clear_values = graph.clear_values();
+        auto const upscale_filter =
+            queues.device.getFormatProperties(target_format).optimalTilingFeatures &
+                    vk::FormatFeatureFlagBits::eSampledImageFilterLinear
+                ? vk::Filter::eLinear
+                : vk::Filter::eNearest;
 		vk::GraphicsPipelineCreateInfo pipeline_info = {
             .stageCount          = 2,
             .pStages             = nullptr,
@@ -545,92 +745,807 @@ main(int argc, char const * const * argv){
 		    .pMultisampleState   = &multisamplestate_info,
 		    .pDepthStencilState  = nullptr,
 		    .pColorBlendState    = &blendstate_info,
-		    .pDynamicState       = nullptr,
+		    .pDynamicState       = &dynamicstate_info,
             .layout              = *pipeline_layout,
-            .renderPass          = *render_pass,
+            .renderPass          = graph.render_pass(),
+            .subpass             = graph.subpass(scene_pass),
 		};
-		auto pipeline =
-		    make_graphics_pipeline(*logic_dev, "default", pipeline_info);
-        std::vector<vk::UniqueFramebuffer> fbos;
-        fbos.reserve(swapchain_image_views.size());
-        for(auto&& image_view : swapchain_image_views){
-            vk::FramebufferCreateInfo i{
-                .renderPass = *render_pass,
-                .attachmentCount = 1,
-                .pAttachments = &*image_view,
-                .width  = swapchain_info.imageExtent.width,
-                .height = swapchain_info.imageExtent.height,
-                .layers = 1,
+		// --pipeline-cache=<file> sets where compiled pipelines are kept
+		// between runs, --no-pipeline-cache compiles from scratch every time
+		auto const use_pipeline_cache = !args.named.contains("no-pipeline-cache");
+		std::filesystem::path const pipeline_cache_path =
+		    get_named<std::string_view>(args, "pipeline-cache")
+		        .value_or("build/pipeline_cache.bin");
+		load_pipeline_cache_t pipeline_cache {};
+		if (use_pipeline_cache)
+			pipeline_cache = load_pipeline_cache(
+			    queues.device, *logic_dev, pipeline_cache_path);
+		auto const pipeline_start = std::chrono::steady_clock::now();
+		auto pipeline = make_graphics_pipeline(
+		    *logic_dev, *pipeline_cache.cache, "default", pipeline_info);
+		std::clog << "pipeline creation: "
+		          << std::chrono::duration<double, std::milli>(
+		                 std::chrono::steady_clock::now() - pipeline_start)
+		                 .count()
+		          << " ms ("
+		          << (!use_pipeline_cache ? "no cache" :
+		              pipeline_cache.warm ? "warm cache" :
+                                            "cold cache")
+		          << ")\n";
+        // --particles[=N] simulates N particles as a compute workload, on the
+        // async compute queue when there is one, and draws them as points
+        auto const particle_count = args.named.contains("particles") ?
+            get_named<std::uint32_t>(args, "particles").value_or(1 << 16) : 0u;
+        vk::PipelineVertexInputStateCreateInfo particle_input_info = {
+            .vertexBindingDescriptionCount   = 1,
+            .pVertexBindingDescriptions      = &particle_binding,
+            .vertexAttributeDescriptionCount = static_cast<std::uint32_t>(particle_attributes.size()),
+            .pVertexAttributeDescriptions    = particle_attributes.data(),
+        };
+        vk::PipelineInputAssemblyStateCreateInfo points_info = {
+            .topology               = vk::PrimitiveTopology::ePointList,
+            .primitiveRestartEnable = false,
+        };
+        auto particle_pipeline_info                = pipeline_info;
+        particle_pipeline_info.pVertexInputState   = &particle_input_info;
+        particle_pipeline_info.pInputAssemblyState = &points_info;
+        decltype(pipeline) particle_pipeline;
+        if (particle_count)
+            particle_pipeline = make_graphics_pipeline(
+                *logic_dev, *pipeline_cache.cache, "particles", particle_pipeline_info);
+        // --watch-shaders[=<dir>] rebuilds the pipelines in the background
+        // when `make shaders` rewrites their shaders, build/shaders by default
+        std::optional<pipeline_reloader> reloader;
+        if (auto const watch_dir = get_named<std::string_view>(args, "watch-shaders")) {
+            reloader.emplace(watch_dir->empty() ? "build/shaders" : *watch_dir);
+            reloader->add("default", [&](shader_overrides const & t_overrides) {
+                return make_graphics_pipeline(
+                    *logic_dev, *pipeline_cache.cache, "default", pipeline_info, &t_overrides);
+            });
+            if (particle_count)
+                reloader->add("particles", [&](shader_overrides const & t_overrides) {
+                    return make_graphics_pipeline(
+                        *logic_dev, *pipeline_cache.cache, "particles", particle_pipeline_info, &t_overrides);
+                });
+            reloader->start();
+        }
+        // --draws=N draws the mesh N times in a grid, one draw call each
+        auto const draws = grid_draws(get_named<std::size_t>(args, "draws").value_or(1));
+        // --instances=N draws the mesh N times in every draw call,
+        // --instance-sweep[=max] benchmarks 1, 10, 100... up to max instances
+        struct instance_buffer{
+            vk::UniqueBuffer buffer;
+            allocation       memory;
+            std::uint32_t    count;
+        };
+        auto const make_instances = [&](std::uint32_t const t_count) {
+            auto const data = grid_instances(std::max(t_count, 1u));
+            instance_buffer out{
+                .buffer = logic_dev->createBufferUnique({
+                    .size        = data.size() * sizeof(instance),
+                    .usage       = vk::BufferUsageFlagBits::eVertexBuffer |
+                                   vk::BufferUsageFlagBits::eStorageBuffer |
+                                   vk::BufferUsageFlagBits::eTransferDst,
+                    .sharingMode = vk::SharingMode::eExclusive,
+                }),
+                .memory = {},
+                .count  = static_cast<std::uint32_t>(data.size()),
             };
-            fbos.push_back(logic_dev->createFramebufferUnique(i));
+            out.memory = allocator.bind(*out.buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+            // read as vertices, and as objects by the culling pass
+            uploads.upload(
+                *out.buffer, 0, std::as_bytes(std::span(data)),
+                vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eShaderRead,
+                vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader);
+            uploads.wait(uploads.flush());
+            return out;
+        };
+        auto const sweep = args.named.contains("instance-sweep");
+        std::vector<std::uint32_t> instance_steps;
+        if (sweep) {
+            auto const max = get_named<std::uint32_t>(args, "instance-sweep").value_or(1'000'000);
+            if (!max)
+                throw std::runtime_error("--instance-sweep takes a positive number");
+            for (std::uint64_t n = 1; n <= max; n *= 10)
+                instance_steps.push_back(static_cast<std::uint32_t>(n));
+        } else {
+            instance_steps.push_back(get_named<std::uint32_t>(args, "instances").value_or(1));
+        }
+        std::size_t instance_step = 0;
+        auto instances = make_instances(instance_steps[instance_step]);
+
+        // everything that depends on the extent, built anew when the
+        // swapchain is recreated while the previous set is retired
+        struct target_resources{
+            vk::UniqueSwapchainKHR               swapchain;
+            offscreen_target                     offscreen;
+            vk::Extent2D                         extent;
+            std::vector<vk::Image>               images;
+            std::vector<vk::UniqueImageView>     views;
+            graph_images                         attachments;
+            std::vector<vk::UniqueFramebuffer>   fbos;
+            std::vector<resolution_bucket>       buckets; // with dynamic resolution only
+            std::vector<vk::UniqueSemaphore>     render_finished; // per swapchain image
+            gpu_timer                            timer;
+        };
+        auto const make_target = [&](vk::SwapchainKHR const t_old_swapchain) {
+            trace_scope const scope("make_target");
+            vk::UniqueSwapchainKHR swapchain;
+            offscreen_target       offscreen;
+            vk::Extent2D           extent;
+            std::vector<vk::Image> images;
+            if (headless) {
+                extent = {
+                    .width  = get_named<std::uint32_t>(args, "width").value_or(1000),
+                    .height = get_named<std::uint32_t>(args, "height").value_or(1000),
+                };
+                offscreen = make_offscreen_target(
+                    allocator,
+                    *logic_dev,
+                    target_format,
+                    extent,
+                    target_usage | vk::ImageUsageFlagBits::eTransferSrc,
+                    present.image_count);
+                for (auto const & image : offscreen.images)
+                    images.push_back(*image);
+            } else {
+                // preferring the current format keeps the render pass compatible
+                vk::SurfaceFormatKHR const current_format{
+                    .format     = target_format,
+                    .colorSpace = target_color_space,
+                };
+                auto swapchain_info = configure_swapchain( {current_format}, present.present_modes, present.image_count, 1, queues.device, *window, sdl_window, t_old_swapchain, target_usage);
+                if (swapchain_info.imageFormat != target_format)
+                    throw std::runtime_error("swapchain format changed");
+                if (queues.graphics.index != queues.present.index) {
+                    swapchain_info.imageSharingMode      = vk::SharingMode::eConcurrent;
+                    swapchain_info.queueFamilyIndexCount = 2;
+                    static auto queue_family_indices     = {
+                        queues.graphics.index,
+                        queues.present.index,
+                    };
+                    swapchain_info.pQueueFamilyIndices = &*queue_family_indices.begin();
+                }
+                swapchain = logic_dev->createSwapchainKHRUnique(swapchain_info);
+                extent    = swapchain_info.imageExtent;
+                images    = logic_dev->getSwapchainImagesKHR(*swapchain);
+            }
+            std::vector<vk::UniqueImageView> views;
+            views.reserve(images.size());
+            for (auto const & image:images) {
+                using cs = vk::ComponentSwizzle;
+                views.push_back(
+                    logic_dev->createImageViewUnique({
+                        .image    = image,
+                        .viewType = vk::ImageViewType::e2D,
+                        .format   = target_format,
+                        .components = { .r = cs::eIdentity, .g = cs::eIdentity, .b = cs::eIdentity, .a = cs::eIdentity, },
+                        .subresourceRange = {
+                                .aspectMask     = vk::ImageAspectFlagBits::eColor,
+                                .baseMipLevel   = 0,
+                                .levelCount     = 1,
+                                .baseArrayLayer = 0,
+                                .layerCount     = 1,
+                            },
+                    })
+                );
+            }
+            graph_images                       attachments;
+            std::vector<vk::UniqueFramebuffer> fbos;
+            std::vector<resolution_bucket>     buckets;
+            if (scaler) {
+                buckets = make_resolution_buckets(
+                    allocator, *logic_dev, graph, target_format, extent, scaler->scales(),
+                    static_cast<std::uint32_t>(images.size()));
+            } else {
+                attachments = graph.make_images(allocator, *logic_dev, extent);
+                fbos.reserve(views.size());
+                for(auto&& image_view : views)
+                    fbos.push_back(graph.make_framebuffer(*logic_dev, attachments, {&*image_view, 1}, extent));
+            }
+            // the present of an image waits on its own semaphore, which is
+            // free again once the image is acquired the next time
+            std::vector<vk::UniqueSemaphore> render_finished;
+            if (swapchain)
+                for (std::size_t i = 0; i < images.size(); ++i)
+                    render_finished.push_back(logic_dev->createSemaphoreUnique({}));
+            // one timing slot per image, the render pass and the culling
+            gpu_timer timer(
+                queues.device,
+                *logic_dev,
+                queues.graphics.timestamp_valid_bits,
+                static_cast<std::uint32_t>(images.size()),
+                cull ? 2 : 1);
+            return target_resources{
+                .swapchain   = std::move(swapchain),
+                .offscreen   = std::move(offscreen),
+                .extent      = extent,
+                .images      = std::move(images),
+                .views       = std::move(views),
+                .attachments = std::move(attachments),
+                .fbos        = std::move(fbos),
+                .buckets     = std::move(buckets),
+                .render_finished = std::move(render_finished),
+                .timer       = std::move(timer),
+            };
+        };
+        auto target = make_target({});
+        auto const frames_in_flight = present.frames_in_flight;
+        std::cout << (headless ? "offscreen" : vk::to_string(target_present_mode)) << ", "
+                  << target.images.size() << " images of " << vk::to_string(target_format)
+                  << ", " << frames_in_flight << " frames in flight\n";
+        // --capture-depth=N readback buffers let the writer fall behind by
+        // N frames before frames are dropped
+        std::optional<frame_capture> capture;
+        if (capture_dir)
+            capture.emplace(
+                allocator,
+                *logic_dev,
+                target_format,
+                target.extent,
+                get_named<std::size_t>(args, "capture-depth").value_or(frames_in_flight + 2),
+                capture_dir->empty() ? "build/capture" : *capture_dir,
+                *capture_file_format);
+        // --serial restores the old fully serialised loop for comparison
+        auto const serial = args.named.contains("serial");
+        frame_scheduler frames(*logic_dev, frames_in_flight, target.images.size(), timeline_of(graphics_timeline));
+        // every frame is recorded anew, --threads=N splits the draws over N
+        // recording threads
+        command_recorder recorder(
+            *logic_dev,
+            queues.graphics.index,
+            frames_in_flight,
+            get_named<std::size_t>(args, "threads").value_or(std::max(1u, std::thread::hardware_concurrency())));
+        std::optional<gpu_culler> culler;
+        auto const cull_zoom = get_named<float>(args, "cull-zoom").value_or(4.0f);
+        if (cull) {
+            auto const max_objects = *std::max_element(instance_steps.begin(), instance_steps.end());
+            if (!gpu_culler::supported(queues.device, max_objects))
+                throw std::runtime_error("too many instances for an indirect draw");
+            culler.emplace(allocator, *logic_dev, *pipeline_cache.cache, frames_in_flight, max_objects, draw_count);
+        }
+        std::optional<particle_system> particles;
+        auto const async_compute = particle_count && queues.compute;
+        auto const queue_compute = async_compute ? logic_dev->getQueue(queues.compute->index, 0) : queue_graphics;
+        // with async compute every slot submits its simulation step on its
+        // own, the graphics submission waits for it before vertex input, on
+        // the compute timeline when there is one
+        struct compute_frame{
+            vk::UniqueCommandPool   pool;
+            vk::UniqueCommandBuffer cmd;
+            vk::UniqueSemaphore     done;
+            std::uint64_t           value;
+        };
+        std::vector<compute_frame> compute_frames;
+        if (particle_count) {
+            std::vector<std::uint32_t> families{queues.graphics.index};
+            if (async_compute)
+                families.push_back(queues.compute->index);
+            particles.emplace(allocator, *logic_dev, *pipeline_cache.cache, families, frames_in_flight, particle_count);
+        }
+        if (async_compute) {
+            for (std::uint32_t i = 0; i < frames_in_flight; ++i) {
+                auto pool = logic_dev->createCommandPoolUnique({
+                    .flags            = vk::CommandPoolCreateFlagBits::eTransient,
+                    .queueFamilyIndex = queues.compute->index,
+                });
+                auto buf = std::move(logic_dev->allocateCommandBuffersUnique({
+                    .commandPool        = *pool,
+                    .level              = vk::CommandBufferLevel::ePrimary,
+                    .commandBufferCount = 1,
+                })[0]);
+                compute_frames.push_back({
+                    .pool = std::move(pool),
+                    .cmd  = std::move(buf),
+                    .done  = timelines ? vk::UniqueSemaphore {} : logic_dev->createSemaphoreUnique({}),
+                    .value = 0,
+                });
+            }
         }
-        vk::CommandPoolCreateInfo cmd_pool_info{
-            .queueFamilyIndex = queue_info[0].queueFamilyIndex,
+        // --particle-steps=K integrates K times per frame, to scale the load
+        auto const particle_steps = get_named<std::uint32_t>(args, "particle-steps").value_or(1);
+        gpu_timer compute_timer(
+            queues.device,
+            *logic_dev,
+            !particle_count ? 0u :
+            async_compute   ? queues.compute->timestamp_valid_bits :
+                              queues.graphics.timestamp_valid_bits,
+            frames_in_flight,
+            1);
+        // targets replaced by a resize, with the frame they were retired at
+        std::vector<std::pair<std::uint64_t, target_resources>> retired_targets;
+        // pipelines replaced by a reload, likewise
+        std::vector<std::pair<std::uint64_t, decltype(pipeline)>> retired_pipelines;
+        bool swapchain_dirty = false;
+        // --fps=<n> holds the loop to a frame rate instead of running flat out
+        std::optional<frame_limiter> limiter;
+        if (auto const fps = get_named<double>(args, "fps"))
+            limiter.emplace(*fps);
+        // --spin=<rad/s> turns the meshes through the per frame uniforms
+        auto const spin = get_named<float>(args, "spin").value_or(0.0f);
+        // goes before the swapchains it waits on
+        std::optional<present_latency> display_latency;
+        if (present_wait)
+            display_latency.emplace(*logic_dev);
+        std::uint64_t present_id = 0;
+        // the latency thread waits on the swapchain, which has to be
+        // externally synchronized with acquiring and presenting
+        auto const lock_swapchain = [&] {
+            return display_latency ? display_latency->lock_swapchain() : std::unique_lock<std::mutex>();
         };
-        auto cmd_pool = logic_dev->createCommandPoolUnique(cmd_pool_info);
-        vk::CommandBufferAllocateInfo cmd_buffer_info{
-            .commandPool = *cmd_pool,
-            .level = vk::CommandBufferLevel::ePrimary,
-            .commandBufferCount = uint32_t( fbos.size()),
+        // --bench-frames=N renders N measured frames after --warmup=M
+        // unmeasured ones and exits, --json switches the report format, a
+        // sweep measures that many frames per step
+        auto const bench_frames = sweep ?
+            std::optional(get_named<std::uint64_t>(args, "bench-frames").value_or(500)) :
+            get_named<std::uint64_t>(args, "bench-frames");
+        auto const warmup = get_named<std::uint64_t>(args, "warmup").value_or(0);
+        std::vector<double> cpu_frame_times;
+        std::vector<double> acquire_times;
+        std::vector<double> record_times;
+        std::vector<double> present_times;
+        // from the event poll, with --latency
+        std::vector<double> input_submit_times;
+        std::vector<double> input_present_times;
+        std::vector<double> gpu_pass_times;
+        std::vector<double> gpu_cull_times;
+        std::vector<double> gpu_compute_times;
+        // where the render passes and the simulation steps ran, to tell how
+        // much of the compute work overlapped with rendering
+        std::vector<std::pair<double, double>> gpu_pass_intervals;
+        std::vector<std::pair<double, double>> gpu_compute_intervals;
+        if (bench_frames) {
+            cpu_frame_times.reserve(*bench_frames);
+            acquire_times.reserve(*bench_frames);
+            record_times.reserve(*bench_frames);
+            present_times.reserve(*bench_frames);
+            if (latency) {
+                input_submit_times.reserve(*bench_frames);
+                input_present_times.reserve(*bench_frames);
+            }
+            gpu_pass_times.reserve(*bench_frames);
+            gpu_cull_times.reserve(*bench_frames);
+            gpu_compute_times.reserve(*bench_frames);
+            gpu_pass_intervals.reserve(*bench_frames);
+            gpu_compute_intervals.reserve(*bench_frames);
+        }
+        // the first frame needs the geometry, later uploads are polled for
+        uploads.wait(geometry_ticket);
+        using ms = std::chrono::duration<double, std::milli>;
+        auto const loop_start = std::chrono::steady_clock::now();
+        startup_scope.end();
+        std::clog << "startup: "
+                  << std::chrono::duration<double, std::milli>(loop_start - startup_start).count()
+                  << " ms\n";
+        auto bench_start = loop_start;
+        auto frame_end   = loop_start;
+        std::uint64_t step_start = 0;
+        sweep_report sweep_results{.parameter = "instances", .steps = {}};
+        auto const make_report = [&] {
+            bench_report report{
+                .frames  = cpu_frame_times.size(),
+                .seconds = std::chrono::duration<double>(frame_end - bench_start).count(),
+                .series  = {
+                    {"cpu frame", summarise(cpu_frame_times)},
+                    {"acquire", summarise(acquire_times)},
+                    {"record", summarise(record_times)},
+                    {"present", summarise(present_times)},
+                    {"gpu pass", summarise(gpu_pass_times)},
+                },
+            };
+            if (culler)
+                report.series.emplace_back("gpu cull", summarise(gpu_cull_times));
+            if (particles) {
+                // assumes the queues share the timestamp clock, which holds
+                // for the usual desktop drivers
+                report.series.emplace_back("gpu compute", summarise(gpu_compute_times));
+                report.series.emplace_back(
+                    "overlap",
+                    summarise(interval_overlaps(gpu_compute_intervals, gpu_pass_intervals)));
+            }
+            if (latency) {
+                report.series.emplace_back("input to submit", summarise(input_submit_times));
+                report.series.emplace_back("input to present", summarise(input_present_times));
+                if (display_latency)
+                    report.series.emplace_back("input to display", summarise(display_latency->take()));
+            }
+            return report;
         };
-        auto cmd_bufs = logic_dev->allocateCommandBuffersUnique(cmd_buffer_info);
-        for(auto [buf, fbo] : utils::zip(cmd_bufs, fbos)){
-            vk::CommandBufferBeginInfo cmd_buf_beg_info{};
-            buf->begin(cmd_buf_beg_info);
-            vk::ClearValue clean{};
+        bool running  = true;
+        while(running && !interrupted){
+            if (limiter)
+                limiter->wait();
+            // input is sampled as late as the limiter allows, this is where
+            // the latency measurements start
+            auto const poll_start = std::chrono::steady_clock::now();
+            trace_scope const frame_scope("frame");
+            SDL_Event e;
+            while(sdl_window && SDL_PollEvent(&e)) {
+                if (e.type == SDL_QUIT)
+                    running = false;
+                else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                    swapchain_dirty = true;
+            }
+            auto const measuring = bench_frames && frames.frame_number() >= step_start + warmup;
+            // acquire includes the fence waits, that's where a gpu bound
+            // frame shows up on the cpu
+            auto const acquire_start = std::chrono::steady_clock::now();
+            trace_scope acquire_scope("acquire");
+            frames.wait_current();
+            uploads.poll();
+            // every frame submitted before a target was retired has finished
+            // once the frame just before the retirement was waited on
+            std::erase_if(retired_targets, [&](auto const & t_retired) {
+                auto const done = frames.frame_number() + 1 >= t_retired.first + frames.frames_in_flight();
+                if (done && display_latency && t_retired.second.swapchain)
+                    display_latency->forget(*t_retired.second.swapchain);
+                return done;
+            });
+            std::erase_if(retired_pipelines, [&](auto const & t_retired) {
+                return frames.frame_number() + 1 >= t_retired.first + frames.frames_in_flight();
+            });
+            if (capture && frames.frame_number() + 1 >= frames.frames_in_flight())
+                capture->finished_before(frames.frame_number() + 1 - frames.frames_in_flight());
+            // reloaded pipelines take over between frames, the frames still
+            // in flight keep using the old ones
+            if (reloader) {
+                for (auto & [name, fresh] : reloader->take_ready()) {
+                    auto & current = name == "particles" ? particle_pipeline : pipeline;
+                    retired_pipelines.emplace_back(frames.frame_number(), std::move(current));
+                    current = std::move(fresh);
+                }
+            }
+            if (swapchain_dirty) {
+                int width  = 0;
+                int height = 0;
+                SDL_Vulkan_GetDrawableSize(sdl_window, &width, &height);
+                if (!width || !height) {
+                    // minimised, there's nothing to render to until restored
+                    SDL_WaitEvent(nullptr);
+                    continue;
+                }
+                // the old set stays alive until the frames using it are done,
+                // so there's no need to wait for the device to go idle
+                auto fresh = [&] {
+                    auto const swapchain_lock = lock_swapchain();
+                    return make_target(*target.swapchain);
+                }();
+                retired_targets.emplace_back(frames.frame_number(), std::move(target));
+                target = std::move(fresh);
+                frames.reset_images(target.images.size());
+                swapchain_dirty = false;
+            }
+            auto const & sync = frames.current();
+            // offscreen images are handed out round robin, the images in
+            // flight table keeps us from reusing one that's still rendering
+            std::uint32_t image_index = 0;
+            if (headless) {
+                image_index = static_cast<std::uint32_t>(frames.frame_number() % target.images.size());
+            } else {
+                try {
+                    auto const swapchain_lock = lock_swapchain();
+                    auto const acquired = logic_dev->acquireNextImageKHR(*target.swapchain, std::numeric_limits<uint64_t>::max(), *sync.image_available);
+                    image_index = acquired.value;
+                    if (acquired.result == vk::Result::eSuboptimalKHR)
+                        swapchain_dirty = true;
+                } catch (vk::OutOfDateKHRError const &) {
+                    swapchain_dirty = true;
+                    continue;
+                }
+            }
+            frames.claim_image(image_index);
+            // the image's previous submission has retired by now, so its
+            // timestamps are ready without waiting
+            auto const gpu_times = target.timer.collect_intervals(image_index);
+            // so has the slot's previous simulation step, the graphics
+            // submission waited for it
+            auto const compute_times = compute_timer.collect_intervals(frames.slot());
+            auto const acquire_end = std::chrono::steady_clock::now();
+            acquire_scope.end();
+            // the scene pass is what the scale changes, without timestamps
+            // the time since the last frame ended stands in for it
+            if (scaler)
+                scaler->update(!gpu_times.empty() ? gpu_times[0].second - gpu_times[0].first
+                                                  : ms(acquire_end - frame_end).count());
+            trace_scope record_scope("record");
+            if (measuring) {
+                acquire_times.push_back(ms(acquire_end - acquire_start).count());
+                if (!gpu_times.empty()) {
+                    gpu_pass_times.push_back(gpu_times[0].second - gpu_times[0].first);
+                    gpu_pass_intervals.push_back(gpu_times[0]);
+                }
+                if (gpu_times.size() > 1)
+                    gpu_cull_times.push_back(gpu_times[1].second - gpu_times[1].first);
+                if (!compute_times.empty()) {
+                    gpu_compute_times.push_back(compute_times[0].second - compute_times[0].first);
+                    gpu_compute_intervals.push_back(compute_times[0]);
+                }
+            }
 
+            particle_constants const particle_step{
+                .dt    = 1.0f / 60.0f,
+                .count = particle_count,
+                .steps = particle_steps,
+                .init  = frames.frame_number() == 0,
+            };
+            if (async_compute) {
+                auto & compute = compute_frames[frames.slot()];
+                logic_dev->resetCommandPool(*compute.pool);
+                compute.cmd->begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+                compute_timer.reset(*compute.cmd, frames.slot());
+                compute_timer.begin(*compute.cmd, frames.slot(), 0);
+                particles->record(*compute.cmd, frames.slot(), particle_step, false);
+                compute_timer.end(*compute.cmd, frames.slot(), 0);
+                compute.cmd->end();
+                submit_semaphores semaphores;
+                if (timelines) {
+                    compute.value = compute_timeline->reserve();
+                    semaphores.add_signal(compute_timeline->semaphore(), compute.value);
+                } else {
+                    semaphores.add_signal(*compute.done);
+                }
+                vk::SubmitInfo compute_submit{
+                    .commandBufferCount = 1,
+                    .pCommandBuffers    = &*compute.cmd,
+                };
+                vk::TimelineSemaphoreSubmitInfo compute_values;
+                semaphores.apply(compute_submit, compute_values, timelines);
+                queue_compute.submit({compute_submit});
+                compute_timer.submitted(frames.slot());
+            }
+
+            auto const cmd = recorder.begin(frames.slot());
+            // the slot's previous frame has retired, its uniforms are free
+            frame_ring.begin(frames.slot());
+            std::chrono::duration<float> const time = poll_start - loop_start;
+            auto const frame_offset = frame_ring.push(frame_uniforms{
+                .time  = time.count(),
+                .angle = spin * time.count(),
+            });
+            target.timer.reset(cmd, image_index);
+            if (particles && !async_compute) {
+                compute_timer.reset(cmd, frames.slot());
+                compute_timer.begin(cmd, frames.slot(), 0);
+                particles->record(cmd, frames.slot(), particle_step, true);
+                compute_timer.end(cmd, frames.slot(), 0);
+            }
+            // the culling view pans over the grid, zoomed in so most of it
+            // is off screen
+            auto const pan = static_cast<float>(frames.frame_number()) * 0.005f;
+            draw_item const view{
+                .offset = {0.5f * cull_zoom * std::cos(pan), 0.5f * cull_zoom * std::sin(pan)},
+                .scale  = cull_zoom,
+            };
+            if (culler) {
+                target.timer.begin(cmd, image_index, 1);
+                culler->record(cmd, frames.slot(), *instances.buffer, {
+                    .offset       = view.offset,
+                    .scale        = view.scale,
+                    .radius       = mesh_bounds,
+                    .object_count = instances.count,
+                    .index_count  = index_count,
+                });
+                target.timer.end(cmd, image_index, 1);
+            }
+            target.timer.begin(cmd, image_index, 0);
+            auto const * bucket = scaler ? &target.buckets[scaler->step()] : nullptr;
+            auto const render_extent = bucket ? bucket->extent : target.extent;
+            auto const framebuffer   = bucket ? *bucket->fbos[image_index] : *target.fbos[image_index];
             vk::RenderPassBeginInfo pass_info{
-                .renderPass  = *render_pass,
-                .framebuffer = *fbo,
+                .renderPass  = graph.render_pass(),
+                .framebuffer = framebuffer,
                 .renderArea = {
                     .offset = {},
-                    .extent = swapchain_info.imageExtent,
+                    .extent = render_extent,
                 },
-                .clearValueCount = 1,
-                .pClearValues = &clean,
+                .clearValueCount = static_cast<std::uint32_t>(clear_values.size()),
+                .pClearValues = clear_values.data(),
             };
-            buf->beginRenderPass(pass_info, vk::SubpassContents::eInline);
-            buf->bindPipeline(vk::PipelineBindPoint::eGraphics, *(pipeline.first));
-            buf->draw(3,1,0,0);
-            buf->endRenderPass();
-            buf->end();
-        }
-        vk::SemaphoreCreateInfo semaphore_info{};
-        auto image_available = logic_dev->createSemaphoreUnique(semaphore_info);
-        auto render_finished = logic_dev->createSemaphoreUnique(semaphore_info);
-        bool running  = true;
-        while(running){
-            SDL_Event e;
-            while(SDL_PollEvent(&e)) if (e.type == SDL_QUIT) running = false;
-            auto image_index = logic_dev->acquireNextImageKHR(*swapchain, std::numeric_limits<uint64_t>::max(), *image_available).value;
-
-            vk::PipelineStageFlags wait_stages{
-                vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            cmd.beginRenderPass(pass_info, vk::SubpassContents::eSecondaryCommandBuffers);
+            vk::CommandBufferInheritanceInfo const inheritance{
+                .renderPass  = graph.render_pass(),
+                .subpass     = graph.subpass(scene_pass),
+                .framebuffer = framebuffer,
             };
+            recorder.record_pass(
+                frames.slot(),
+                inheritance,
+                culler ? 1 : draws.size(),
+                [&](vk::CommandBuffer const & t_cmd, std::size_t t_first, std::size_t t_count) {
+                    t_cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *(pipeline.first));
+                    t_cmd.bindDescriptorSets(
+                        vk::PipelineBindPoint::eGraphics, *pipeline_layout, 0, frame_ring.set(), frame_offset);
+                    t_cmd.setViewport(0, vk::Viewport{
+                        .x        = 0,
+                        .y        = 0,
+                        .width    = static_cast<float>(render_extent.width),
+                        .height   = static_cast<float>(render_extent.height),
+                        .minDepth = 0,
+                        .maxDepth = 1,
+                    });
+                    t_cmd.setScissor(0, vk::Rect2D{.offset = {}, .extent = render_extent});
+                    std::array const vertex_buffers{*vertex_buffer, *instances.buffer};
+                    std::array const vertex_offsets{vk::DeviceSize{0}, vk::DeviceSize{0}};
+                    t_cmd.bindVertexBuffers(0, vertex_buffers, vertex_offsets);
+                    t_cmd.bindIndexBuffer(*index_buffer, 0, index_type);
+                    if (culler) {
+                        t_cmd.pushConstants<draw_item>(*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, view);
+                        culler->draw(t_cmd, frames.slot(), instances.count);
+                        return;
+                    }
+                    for (auto const & draw : std::span(draws).subspan(t_first, t_count)) {
+                        t_cmd.pushConstants<draw_item>(*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, draw);
+                        t_cmd.drawIndexed(index_count, instances.count, 0, 0, 0);
+                    }
+                });
+            if (particles)
+                recorder.record_pass(
+                    frames.slot(),
+                    inheritance,
+                    1,
+                    [&](vk::CommandBuffer const & t_cmd, std::size_t, std::size_t) {
+                        t_cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *(particle_pipeline.first));
+                        t_cmd.setViewport(0, vk::Viewport{
+                            .x        = 0,
+                            .y        = 0,
+                            .width    = static_cast<float>(render_extent.width),
+                            .height   = static_cast<float>(render_extent.height),
+                            .minDepth = 0,
+                            .maxDepth = 1,
+                        });
+                        t_cmd.setScissor(0, vk::Rect2D{.offset = {}, .extent = render_extent});
+                        t_cmd.bindVertexBuffers(0, particles->buffer(frames.slot()), vk::DeviceSize{0});
+                        t_cmd.draw(particles->count(), 1, 0, 0);
+                    });
+            cmd.endRenderPass();
+            target.timer.end(cmd, image_index, 0);
+            if (bucket)
+                record_upscale(
+                    cmd, *bucket->color.images[image_index], render_extent,
+                    target.images[image_index], target.extent, target_layout, upscale_filter);
+            if (capture)
+                capture->record(cmd, target.images[image_index], target_layout, target.extent, frames.frame_number());
+            cmd.end();
+            auto const record_end = std::chrono::steady_clock::now();
+            record_scope.end();
+            trace_scope submit_scope("submit");
+            if (measuring)
+                record_times.push_back(ms(record_end - acquire_end).count());
+
+            // the binary semaphores of the swapchain go along with the
+            // timeline values, which the submit info ignores for them
+            submit_semaphores semaphores;
+            if (!headless) {
+                // the upscale writes the image in a blit
+                semaphores.add_wait(
+                    *sync.image_available,
+                    scaler ? vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlagBits::eColorAttachmentOutput);
+                semaphores.add_signal(*target.render_finished[image_index]);
+            }
+            if (async_compute) {
+                auto const & compute = compute_frames[frames.slot()];
+                if (timelines)
+                    semaphores.add_wait(compute_timeline->semaphore(), vk::PipelineStageFlagBits::eVertexInput, compute.value);
+                else
+                    semaphores.add_wait(*compute.done, vk::PipelineStageFlagBits::eVertexInput);
+            }
+            if (timelines)
+                semaphores.add_signal(graphics_timeline->semaphore(), frames.signal_value());
             vk::SubmitInfo submit_info{
-                .waitSemaphoreCount = 1,
-                .pWaitSemaphores = &*image_available,
-                .pWaitDstStageMask = &wait_stages,
                 .commandBufferCount = 1,
-                .pCommandBuffers = &*(cmd_bufs[image_index]),
-                .signalSemaphoreCount = 1,
-                .pSignalSemaphores = &*render_finished,
-            };
-            queue_graphics.submit({submit_info});
-            vk::PresentInfoKHR present_info{
-                .waitSemaphoreCount = 1,
-                .pWaitSemaphores = &*render_finished,
-                .swapchainCount = 1,
-                .pSwapchains = &*swapchain,
-                .pImageIndices = &image_index,
+                .pCommandBuffers = &cmd,
             };
-            auto result = queue_present.presentKHR(present_info);
-            if(result != vk::Result::eSuccess && result != vk::Result::eErrorOutOfDateKHR && result != vk::Result::eSuboptimalKHR)
-                throw std::runtime_error(vk::to_string(result));
-            queue_present.waitIdle();
+            vk::TimelineSemaphoreSubmitInfo submit_values;
+            semaphores.apply(submit_info, submit_values, timelines);
+            queue_graphics.submit({submit_info}, frames.fence());
+            submit_scope.end();
+            target.timer.submitted(image_index);
+            if (particles && !async_compute)
+                compute_timer.submitted(frames.slot());
+            auto const present_start = std::chrono::steady_clock::now();
+            trace_scope present_scope("present");
+            if (!headless) {
+                ++present_id;
+                vk::PresentIdKHR const present_ids{
+                    .swapchainCount = 1,
+                    .pPresentIds    = &present_id,
+                };
+                vk::PresentInfoKHR present_info{
+                    .pNext = display_latency ? &present_ids : nullptr,
+                    .waitSemaphoreCount = 1,
+                    .pWaitSemaphores = &*target.render_finished[image_index],
+                    .swapchainCount = 1,
+                    .pSwapchains = &*target.swapchain,
+                    .pImageIndices = &image_index,
+                };
+                try {
+                    auto const swapchain_lock = lock_swapchain();
+                    if (queue_present.presentKHR(present_info) == vk::Result::eSuboptimalKHR)
+                        swapchain_dirty = true;
+                    if (display_latency && measuring)
+                        display_latency->presented(*target.swapchain, present_id, poll_start);
+                } catch (vk::OutOfDateKHRError const &) {
+                    swapchain_dirty = true;
+                }
+            }
+            if (serial)
+                queue_present.waitIdle();
+            present_scope.end();
+            frames.advance();
+
+            auto const now = std::chrono::steady_clock::now();
+            if (measuring) {
+                present_times.push_back(ms(now - present_start).count());
+                if (latency) {
+                    input_submit_times.push_back(ms(present_start - poll_start).count());
+                    input_present_times.push_back(ms(now - poll_start).count());
+                }
+                cpu_frame_times.push_back(ms(now - frame_end).count());
+            } else {
+                bench_start = now;
+            }
+            frame_end = now;
+            if (measuring && cpu_frame_times.size() >= *bench_frames) {
+                if (sweep)
+                    sweep_results.steps.emplace_back(instances.count, make_report());
+                if (!sweep || ++instance_step == instance_steps.size()) {
+                    running = false;
+                } else {
+                    // the old instances can only go once nothing uses them
+                    logic_dev->waitIdle();
+                    instances = make_instances(instance_steps[instance_step]);
+                    for (auto * series : {&cpu_frame_times, &acquire_times, &record_times, &present_times, &input_submit_times, &input_present_times, &gpu_pass_times, &gpu_cull_times, &gpu_compute_times})
+                        series->clear();
+                    if (display_latency)
+                        display_latency->take();
+                    gpu_pass_intervals.clear();
+                    gpu_compute_intervals.clear();
+                    step_start  = frames.frame_number();
+                    bench_start = frame_end = std::chrono::steady_clock::now();
+                }
+            }
         }
         logic_dev->waitIdle();
+        if (capture) {
+            capture->flush();
+            std::clog << "capture: " << capture->written() << " frames written, "
+                      << capture->dropped() << " dropped, " << capture->failed() << " failed\n";
+        }
+        if (scaler)
+            std::clog << "dynamic resolution: scale " << scaler->scale() << " after "
+                      << scaler->changes() << " changes\n";
+        print_allocator_stats(std::clog, allocator.stats());
+        if (use_pipeline_cache) {
+            // losing the cache only costs the next startup, don't fail on it
+            try {
+                save_pipeline_cache(queues.device, *logic_dev, *pipeline_cache.cache, pipeline_cache_path);
+            } catch (std::exception const & ex) {
+                std::clog << "could not save the pipeline cache: " << ex.what() << '\n';
+            }
+        }
+        if (sweep) {
+            if (args.named.contains("json"))
+                print_sweep_json(std::cout, sweep_results);
+            else
+                print_sweep(std::cout, sweep_results);
+        } else if (bench_frames) {
+            auto const report = make_report();
+            if (args.named.contains("json"))
+                print_report_json(std::cout, report);
+            else
+                print_report(std::cout, report);
+        } else {
+            std::chrono::duration<double> const elapsed =
+                std::chrono::steady_clock::now() - loop_start;
+            std::cout << frames.frame_number() << " frames in " << elapsed.count()
+                      << " s, " << static_cast<double>(frames.frame_number()) / elapsed.count()
+                      << " fps, ";
+            if (serial)
+                std::cout << "serial\n";
+            else
+                std::cout << frames.frames_in_flight() << " frames in flight, "
+                          << (timelines ? "timelines" : "fences") << '\n';
+        }
 	}
-	SDL_DestroyWindow(sdl_window);
 	return 0;
 }
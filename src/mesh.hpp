@@ -0,0 +1,115 @@
+#ifndef MESH_HPP_INCLUDED
+#define MESH_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+///
+///@brief per vertex data of the default pipeline
+///
+struct vertex{
+	std::array<float, 2> position;
+	std::array<float, 3> color;
+};
+
+///
+///@brief per instance data of the default pipeline
+///
+struct instance{
+	std::array<float, 2> offset;
+	float                scale;
+	std::array<float, 3> color;
+};
+
+inline constexpr std::array<vk::VertexInputBindingDescription, 2> vertex_bindings {{
+    {
+        .binding   = 0,
+        .stride    = sizeof(vertex),
+        .inputRate = vk::VertexInputRate::eVertex,
+    },
+    {
+        .binding   = 1,
+        .stride    = sizeof(instance),
+        .inputRate = vk::VertexInputRate::eInstance,
+    },
+}};
+
+inline constexpr std::array<vk::VertexInputAttributeDescription, 5> vertex_attributes {{
+    {
+        .location = 0,
+        .binding  = 0,
+        .format   = vk::Format::eR32G32Sfloat,
+        .offset   = offsetof(vertex, position),
+    },
+    {
+        .location = 1,
+        .binding  = 0,
+        .format   = vk::Format::eR32G32B32Sfloat,
+        .offset   = offsetof(vertex, color),
+    },
+    {
+        .location = 2,
+        .binding  = 1,
+        .format   = vk::Format::eR32G32Sfloat,
+        .offset   = offsetof(instance, offset),
+    },
+    {
+        .location = 3,
+        .binding  = 1,
+        .format   = vk::Format::eR32Sfloat,
+        .offset   = offsetof(instance, scale),
+    },
+    {
+        .location = 4,
+        .binding  = 1,
+        .format   = vk::Format::eR32G32B32Sfloat,
+        .offset   = offsetof(instance, color),
+    },
+}};
+
+///
+///@brief push constants of the default pipeline, placing one draw
+///
+struct draw_item{
+	std::array<float, 2> offset;
+	float                scale;
+};
+
+///
+///@brief uniform block of the default pipeline, pushed once per frame
+///
+struct frame_uniforms{
+	float time;  ///< seconds since the loop started
+	float angle; ///< radians every mesh is turned by
+};
+
+///
+///@brief the triangle the default pipeline used to hard-code in its shader
+///
+inline constexpr std::array<vertex, 3> triangle_vertices {{
+    {.position = {0.0f, -0.5f}, .color = {1.0f, 0.0f, 0.0f}},
+    {.position = {0.5f, 0.5f}, .color = {0.0f, 1.0f, 0.0f}},
+    {.position = {-0.5f, 0.5f}, .color = {0.0f, 0.0f, 1.0f}},
+}};
+
+inline constexpr std::array<std::uint16_t, 3> triangle_indices {0, 1, 2};
+
+///
+///@brief radius of the bounding circle around the origin
+///
+inline float
+mesh_radius(std::span<vertex const> t_vertices)
+{
+	float out = 0;
+	for (auto const & v : t_vertices)
+		out = std::max(out, std::hypot(v.position[0], v.position[1]));
+	return out;
+}
+
+#endif // MESH_HPP_INCLUDED
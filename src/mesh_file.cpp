@@ -0,0 +1,380 @@
+#include "mesh_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::uint64_t
+align_up(std::uint64_t t_offset)
+{
+	return (t_offset + mesh_file_alignment - 1) / mesh_file_alignment * mesh_file_alignment;
+}
+
+///
+///@brief splits off the next whitespace separated token
+///
+std::string_view
+next_token(std::string_view & t_line)
+{
+	auto const begin = t_line.find_first_not_of(" \t\r");
+	if (begin == std::string_view::npos) {
+		t_line = {};
+		return {};
+	}
+	auto const end = std::min(t_line.find_first_of(" \t\r", begin), t_line.size());
+	auto const out = t_line.substr(begin, end - begin);
+	t_line.remove_prefix(end);
+	return out;
+}
+
+template<class T>
+std::optional<T>
+parse_number(std::string_view t_token)
+{
+	T out {};
+	auto const [end, ec] = std::from_chars(t_token.data(), t_token.data() + t_token.size(), out);
+	if (ec != std::errc {} || end == t_token.data())
+		return std::nullopt;
+	return out;
+}
+
+void
+normalise(std::vector<vertex> & t_vertices)
+{
+	if (t_vertices.empty())
+		return;
+	std::array<float, 2> low  = t_vertices.front().position;
+	std::array<float, 2> high = low;
+	for (auto const & v : t_vertices)
+		for (std::size_t i = 0; i < 2; ++i) {
+			low[i]  = std::min(low[i], v.position[i]);
+			high[i] = std::max(high[i], v.position[i]);
+		}
+	std::array const center {(low[0] + high[0]) / 2, (low[1] + high[1]) / 2};
+	float            radius = 0;
+	for (auto & v : t_vertices) {
+		v.position[0] -= center[0];
+		v.position[1] -= center[1];
+		radius = std::max(radius, std::hypot(v.position[0], v.position[1]));
+	}
+	if (radius == 0)
+		return;
+	for (auto & v : t_vertices)
+		for (auto & p : v.position)
+			p *= 0.5f / radius;
+}
+
+template<class F>
+double
+best_seconds(F t_run)
+{
+	// the first run warms the page cache for all of them
+	auto best = std::numeric_limits<double>::max();
+	for (int i = 0; i < 5; ++i) {
+		auto const start = std::chrono::steady_clock::now();
+		t_run();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+///
+///@brief checks every index against the vertex count, an index past the
+/// vertices would have the draw read outside the vertex buffer
+///
+template<class T>
+bool
+indices_in_range(std::span<std::byte const> t_indices, std::uint32_t t_vertex_count)
+{
+	// the offset is aligned for either index size
+	std::span<T const> const indices {
+	    reinterpret_cast<T const *>(t_indices.data()), t_indices.size() / sizeof(T)};
+	return std::all_of(indices.begin(), indices.end(), [&](T t_index) {
+		return t_index < t_vertex_count;
+	});
+}
+
+bool
+indices_in_range(mapped_mesh const & t_mesh)
+{
+	return t_mesh.index_type() == vk::IndexType::eUint16
+	           ? indices_in_range<std::uint16_t>(t_mesh.index_bytes(), t_mesh.vertex_count())
+	           : indices_in_range<std::uint32_t>(t_mesh.index_bytes(), t_mesh.vertex_count());
+}
+
+} // namespace
+
+mapped_mesh::mapped_mesh(std::filesystem::path const & t_path)
+{
+	auto const fd = open(t_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw std::system_error(errno, std::generic_category(), t_path.string());
+	struct stat info {};
+	if (fstat(fd, &info) < 0) {
+		auto const error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), t_path.string());
+	}
+	m_size = static_cast<std::size_t>(info.st_size);
+	if (m_size < sizeof(mesh_file_header)) {
+		close(fd);
+		throw std::runtime_error(t_path.string() + " is too small for a mesh file");
+	}
+	// prefaulting saves a page fault per page on the way into staging
+	auto * const data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	auto const   error = errno;
+	// the mapping keeps the file alive on its own
+	close(fd);
+	if (data == MAP_FAILED)
+		throw std::system_error(error, std::generic_category(), t_path.string());
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data   = data;
+	m_header = static_cast<mesh_file_header const *>(data);
+
+	auto const & h       = *m_header;
+	auto const   fits    = [&](std::uint64_t t_offset, std::uint64_t t_bytes) {
+		return t_offset % mesh_file_alignment == 0 && t_offset <= m_size && t_bytes <= m_size - t_offset;
+	};
+	char const * problem = nullptr;
+	if (h.magic != mesh_file_magic)
+		problem = " is not a mesh file";
+	else if (h.version != mesh_file_version)
+		problem = " has an unknown mesh file version";
+	else if (h.vertex_stride != sizeof(vertex) || (h.index_size != 2 && h.index_size != 4))
+		problem = " has a vertex or index layout this build doesn't read";
+	else if (!h.vertex_count || !h.index_count)
+		problem = " has no triangles";
+	else if (h.index_count % 3 ||
+	         !fits(h.vertex_offset, std::uint64_t {h.vertex_count} * h.vertex_stride) ||
+	         !fits(h.index_offset, std::uint64_t {h.index_count} * h.index_size) ||
+	         !indices_in_range(*this))
+		problem = " is truncated or damaged";
+	if (problem) {
+		munmap(data, m_size);
+		throw std::runtime_error(t_path.string() + problem);
+	}
+}
+
+mapped_mesh::mapped_mesh(mapped_mesh && t_other) noexcept
+{
+	*this = std::move(t_other);
+}
+
+mapped_mesh &
+mapped_mesh::operator=(mapped_mesh && t_other) noexcept
+{
+	if (this == &t_other)
+		return *this;
+	if (m_data)
+		munmap(const_cast<void *>(m_data), m_size);
+	m_data   = std::exchange(t_other.m_data, nullptr);
+	m_size   = std::exchange(t_other.m_size, 0);
+	m_header = std::exchange(t_other.m_header, nullptr);
+	return *this;
+}
+
+mapped_mesh::~mapped_mesh()
+{
+	if (m_data)
+		munmap(const_cast<void *>(m_data), m_size);
+}
+
+std::size_t
+mapped_mesh::size() const
+{
+	return m_size;
+}
+
+std::uint32_t
+mapped_mesh::vertex_count() const
+{
+	return m_header->vertex_count;
+}
+
+std::uint32_t
+mapped_mesh::index_count() const
+{
+	return m_header->index_count;
+}
+
+vk::IndexType
+mapped_mesh::index_type() const
+{
+	return m_header->index_size == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+std::span<vertex const>
+mapped_mesh::vertices() const
+{
+	// the offset is aligned way past alignof(vertex)
+	return {reinterpret_cast<vertex const *>(vertex_bytes().data()), m_header->vertex_count};
+}
+
+std::span<std::byte const>
+mapped_mesh::vertex_bytes() const
+{
+	return {static_cast<std::byte const *>(m_data) + m_header->vertex_offset,
+	        std::size_t {m_header->vertex_count} * m_header->vertex_stride};
+}
+
+std::span<std::byte const>
+mapped_mesh::index_bytes() const
+{
+	return {static_cast<std::byte const *>(m_data) + m_header->index_offset,
+	        std::size_t {m_header->index_count} * m_header->index_size};
+}
+
+mesh_data
+parse_obj(std::istream & t_in)
+{
+	mesh_data   out;
+	std::string line;
+	std::vector<std::uint32_t> corners;
+	while (std::getline(t_in, line)) {
+		std::string_view rest = line;
+		auto const       kind = next_token(rest);
+		if (kind == "v") {
+			std::array<float, 6> values {0, 0, 0, 1, 1, 1};
+			std::size_t          count = 0;
+			for (auto token = next_token(rest); !token.empty() && count < values.size(); token = next_token(rest))
+				if (auto const value = parse_number<float>(token))
+					values[count++] = *value;
+			// without vertex colors the mesh is white and takes the color
+			// of its instances
+			out.vertices.push_back({
+			    .position = {values[0], values[1]},
+			    .color    = count >= 6 ? std::array {values[3], values[4], values[5]}
+			                           : std::array {1.0f, 1.0f, 1.0f},
+			});
+		} else if (kind == "f") {
+			corners.clear();
+			for (auto token = next_token(rest); !token.empty(); token = next_token(rest)) {
+				// v, v/vt, v//vn or v/vt/vn, only the position matters
+				auto const index = parse_number<std::int64_t>(token.substr(0, token.find('/')));
+				auto const count = static_cast<std::int64_t>(out.vertices.size());
+				// negative indices count back from the latest position
+				auto const resolved = !index ? -1 : *index < 0 ? count + *index : *index - 1;
+				if (resolved < 0 || resolved >= count)
+					throw std::runtime_error("obj face refers to a missing position: " + line);
+				corners.push_back(static_cast<std::uint32_t>(resolved));
+			}
+			for (std::size_t i = 2; i < corners.size(); ++i)
+				out.indices.insert(out.indices.end(), {corners[0], corners[i - 1], corners[i]});
+		}
+	}
+	normalise(out.vertices);
+	return out;
+}
+
+void
+write_mesh_file(std::filesystem::path const & t_path, mesh_data const & t_mesh)
+{
+	auto const small = t_mesh.vertices.size() <= std::numeric_limits<std::uint16_t>::max() + std::size_t {1};
+	mesh_file_header header {
+	    .magic         = mesh_file_magic,
+	    .version       = mesh_file_version,
+	    .vertex_count  = static_cast<std::uint32_t>(t_mesh.vertices.size()),
+	    .index_count   = static_cast<std::uint32_t>(t_mesh.indices.size()),
+	    .vertex_stride = sizeof(vertex),
+	    .index_size    = small ? 2u : 4u,
+	    .vertex_offset = align_up(sizeof(mesh_file_header)),
+	    .index_offset  = 0,
+	};
+	header.index_offset = align_up(header.vertex_offset + t_mesh.vertices.size() * sizeof(vertex));
+
+	std::ofstream out(t_path, std::ios::binary);
+	auto const    pad_to = [&](std::uint64_t t_offset) {
+		std::array<char, mesh_file_alignment> const zeros {};
+		out.write(zeros.data(), static_cast<std::streamsize>(t_offset - static_cast<std::uint64_t>(out.tellp())));
+	};
+	out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+	pad_to(header.vertex_offset);
+	out.write(
+	    reinterpret_cast<char const *>(t_mesh.vertices.data()),
+	    static_cast<std::streamsize>(t_mesh.vertices.size() * sizeof(vertex)));
+	pad_to(header.index_offset);
+	if (small) {
+		std::vector<std::uint16_t> narrow(t_mesh.indices.begin(), t_mesh.indices.end());
+		out.write(
+		    reinterpret_cast<char const *>(narrow.data()),
+		    static_cast<std::streamsize>(narrow.size() * sizeof(std::uint16_t)));
+	} else {
+		out.write(
+		    reinterpret_cast<char const *>(t_mesh.indices.data()),
+		    static_cast<std::streamsize>(t_mesh.indices.size() * sizeof(std::uint32_t)));
+	}
+	if (!out)
+		throw std::runtime_error("could not write " + t_path.string());
+}
+
+void
+benchmark_mesh_load(
+    std::filesystem::path const &                t_mesh,
+    std::optional<std::filesystem::path> const & t_obj,
+    std::ostream &                               t_out)
+{
+	// stands in for the mapped staging buffer the uploader copies into
+	std::vector<std::byte> staging;
+	std::size_t            file_size = 0;
+	{
+		mapped_mesh const mesh(t_mesh);
+		file_size = mesh.size();
+		staging.resize(mesh.vertex_bytes().size() + mesh.index_bytes().size());
+	}
+	auto const report = [&](char const * t_name, std::size_t t_bytes, double t_seconds) {
+		t_out << t_name << ": " << t_seconds * 1000 << " ms, "
+		      << static_cast<double>(t_bytes) / t_seconds / 1e9 << " GB/s\n";
+	};
+
+	auto const mapped = best_seconds([&] {
+		mapped_mesh const mesh(t_mesh);
+		auto const        vertices = mesh.vertex_bytes();
+		auto const        indices  = mesh.index_bytes();
+		std::memcpy(staging.data(), vertices.data(), vertices.size());
+		std::memcpy(staging.data() + vertices.size(), indices.data(), indices.size());
+	});
+	report("mmap into staging", file_size, mapped);
+
+	// the way shaders used to be read, the whole file onto the heap first
+	auto const heap = best_seconds([&] {
+		std::ifstream          in(t_mesh, std::ios::binary);
+		std::vector<std::byte> file(file_size);
+		in.read(reinterpret_cast<char *>(file.data()), static_cast<std::streamsize>(file.size()));
+		mesh_file_header header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		auto const vertex_size = std::size_t {header.vertex_count} * header.vertex_stride;
+		auto const index_size  = std::size_t {header.index_count} * header.index_size;
+		std::memcpy(staging.data(), file.data() + header.vertex_offset, vertex_size);
+		std::memcpy(staging.data() + vertex_size, file.data() + header.index_offset, index_size);
+	});
+	report("ifstream into heap into staging", file_size, heap);
+
+	if (t_obj) {
+		auto const obj_size = std::filesystem::file_size(*t_obj);
+		auto const parsed   = best_seconds([&] {
+			std::ifstream in(*t_obj);
+			auto const    mesh = parse_obj(in);
+			std::memcpy(staging.data(), mesh.vertices.data(), std::min(staging.size(), mesh.vertices.size() * sizeof(vertex)));
+		});
+		report("parsing the obj", obj_size, parsed);
+	}
+	// keeps the copies from being optimised away
+	volatile auto const sink = staging.empty() ? std::byte {} : staging.back();
+	static_cast<void>(sink);
+}
@@ -0,0 +1,111 @@
+#ifndef MESH_FILE_HPP_INCLUDED
+#define MESH_FILE_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+#include "mesh.hpp"
+
+///
+///@brief header at the start of a mesh file
+///
+/// The vertices follow as an array of vertex, the indices as 16 bit
+/// indices when every vertex can be reached with them and 32 bit ones
+/// otherwise. Both arrays start at a multiple of mesh_file_alignment, so
+/// they can be used in place wherever the file is mapped.
+///
+struct mesh_file_header{
+	std::array<char, 4> magic; ///< "MESH"
+	std::uint32_t       version;
+	std::uint32_t       vertex_count;
+	std::uint32_t       index_count;
+	std::uint32_t       vertex_stride; ///< sizeof(vertex) when it was written
+	std::uint32_t       index_size;    ///< 2 or 4 bytes
+	std::uint64_t       vertex_offset; ///< from the start of the file
+	std::uint64_t       index_offset;
+};
+
+inline constexpr std::array<char, 4> mesh_file_magic {'M', 'E', 'S', 'H'};
+inline constexpr std::uint32_t       mesh_file_version   = 1;
+inline constexpr std::size_t         mesh_file_alignment = 64;
+
+///
+///@brief geometry as the converter reads it, before it's written out
+///
+struct mesh_data{
+	std::vector<vertex>        vertices;
+	std::vector<std::uint32_t> indices;
+};
+
+///
+///@brief a mesh file mapped into memory, read only
+///
+/// The pages are prefaulted and only ever read from front to back, the
+/// arrays can go straight from the mapping into a staging buffer without
+/// a copy on the heap in between.
+///
+class mapped_mesh{
+	void const *             m_data = nullptr;
+	std::size_t              m_size = 0;
+	mesh_file_header const * m_header = nullptr;
+
+	public:
+	///
+	///@throws std::system_error when the file can't be mapped
+	///@throws std::runtime_error when it isn't a mesh file this build reads
+	///
+	explicit mapped_mesh(std::filesystem::path const & t_path);
+	mapped_mesh(mapped_mesh && t_other) noexcept;
+	mapped_mesh & operator=(mapped_mesh && t_other) noexcept;
+	mapped_mesh(mapped_mesh const &) = delete;
+	mapped_mesh & operator=(mapped_mesh const &) = delete;
+	~mapped_mesh();
+
+	std::size_t   size() const; ///< of the whole file
+	std::uint32_t vertex_count() const;
+	std::uint32_t index_count() const;
+	vk::IndexType index_type() const;
+
+	std::span<vertex const>    vertices() const;
+	std::span<std::byte const> vertex_bytes() const;
+	std::span<std::byte const> index_bytes() const;
+};
+
+///
+///@brief reads the positions, vertex colors if there are any, and faces of
+/// a wavefront obj file
+///
+/// Only x and y of the positions are kept, the meshes are flat, and they're
+/// centered and scaled to fit a radius of 0.5 like the built in triangle.
+/// Faces with more than three corners are split up into fans.
+///
+///@throws std::runtime_error on a face that refers to a missing position
+///
+mesh_data parse_obj(std::istream & t_in);
+
+///
+///@brief writes the mesh in the layout mesh_file_header describes
+///
+///@throws std::runtime_error when the file can't be written
+///
+void write_mesh_file(std::filesystem::path const & t_path, mesh_data const & t_mesh);
+
+///
+///@brief times loading the mesh file into a stand in for a staging buffer,
+/// mapped against read into the heap with an ifstream, and parsing the obj
+/// it was converted from if there is one
+///
+void benchmark_mesh_load(
+    std::filesystem::path const &                t_mesh,
+    std::optional<std::filesystem::path> const & t_obj,
+    std::ostream &                               t_out);
+
+#endif // MESH_FILE_HPP_INCLUDED
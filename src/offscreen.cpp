@@ -0,0 +1,46 @@
+#include "offscreen.hpp"
+
+offscreen_target
+make_offscreen_target(
+    device_allocator &  t_alloc,
+    vk::Device const &  t_dev,
+    vk::Format          t_format,
+    vk::Extent2D        t_extent,
+    vk::ImageUsageFlags t_usage,
+    std::uint32_t       t_count)
+{
+	offscreen_target out {
+	    .memory = {},
+	    .images = {},
+	    .format = t_format,
+	    .extent = t_extent,
+	};
+	out.memory.reserve(t_count);
+	out.images.reserve(t_count);
+	for (std::uint32_t i = 0; i < t_count; ++i)
+	{
+		auto image = t_dev.createImageUnique({
+		    .imageType = vk::ImageType::e2D,
+		    .format    = t_format,
+		    .extent =
+		        {
+		            .width  = t_extent.width,
+		            .height = t_extent.height,
+		            .depth  = 1,
+		        },
+		    .mipLevels     = 1,
+		    .arrayLayers   = 1,
+		    .samples       = vk::SampleCountFlagBits::e1,
+		    .tiling        = vk::ImageTiling::eOptimal,
+		    .usage         = t_usage,
+		    .sharingMode   = vk::SharingMode::eExclusive,
+		    .initialLayout = vk::ImageLayout::eUndefined,
+		});
+		out.memory.push_back(t_alloc.bind(
+		    *image,
+		    vk::ImageTiling::eOptimal,
+		    vk::MemoryPropertyFlagBits::eDeviceLocal));
+		out.images.push_back(std::move(image));
+	}
+	return out;
+}
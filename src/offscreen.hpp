@@ -0,0 +1,33 @@
+#ifndef OFFSCREEN_HPP_INCLUDED
+#define OFFSCREEN_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+#include "allocator.hpp"
+
+///
+///@brief a set of device local images that stand in for the swapchain when
+/// there's no surface to present to
+///
+struct offscreen_target{
+	std::vector<allocation>      memory;
+	std::vector<vk::UniqueImage> images;
+	vk::Format                   format;
+	vk::Extent2D                 extent;
+};
+
+///
+///@brief creates t_count 2d single sampled images backed by device memory
+///
+offscreen_target
+make_offscreen_target(
+    device_allocator &  t_alloc,
+    vk::Device const &  t_dev,
+    vk::Format          t_format,
+    vk::Extent2D        t_extent,
+    vk::ImageUsageFlags t_usage,
+    std::uint32_t       t_count);
+
+#endif // OFFSCREEN_HPP_INCLUDED
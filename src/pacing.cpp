@@ -0,0 +1,143 @@
+#include "pacing.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::chrono::steady_clock::duration
+period(double t_fps)
+{
+	if (!(t_fps > 0))
+		throw std::invalid_argument("the frame rate must be positive");
+	return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	    std::chrono::duration<double>(1.0 / t_fps));
+}
+
+} // namespace
+
+frame_limiter::frame_limiter(double t_fps, std::chrono::microseconds t_spin)
+    : m_period(period(t_fps))
+    , m_spin(t_spin)
+    , m_due(clock::now())
+{}
+
+void
+frame_limiter::wait()
+{
+	auto now = clock::now();
+	if (now < m_due - m_spin)
+		std::this_thread::sleep_until(m_due - m_spin);
+	while ((now = clock::now()) < m_due)
+		std::this_thread::yield();
+	// a frame that's more than an interval late starts the schedule anew
+	// instead of letting the following ones run unlimited to catch up
+	m_due = now - m_due > m_period ? now + m_period : m_due + m_period;
+}
+
+std::vector<char const *>
+present_latency::required_extensions()
+{
+	return {"VK_KHR_present_id", "VK_KHR_present_wait"};
+}
+
+present_latency::present_latency(vk::Device const & t_dev)
+    : m_dev(t_dev)
+    , m_wait_for_present(
+          reinterpret_cast<PFN_vkWaitForPresentKHR>(t_dev.getProcAddr("vkWaitForPresentKHR")))
+{
+	if (!m_wait_for_present)
+		throw std::runtime_error("vkWaitForPresentKHR is missing");
+	m_thread = std::thread(&present_latency::run, this);
+}
+
+present_latency::~present_latency()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+void
+present_latency::presented(
+    vk::SwapchainKHR const & t_swapchain,
+    std::uint64_t            t_id,
+    clock::time_point        t_start)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_pending.push_back({.swapchain = t_swapchain, .id = t_id, .start = t_start});
+	}
+	m_wake.notify_one();
+}
+
+std::unique_lock<std::mutex>
+present_latency::lock_swapchain()
+{
+	++m_contending;
+	std::unique_lock lock(m_swapchain);
+	--m_contending;
+	return lock;
+}
+
+void
+present_latency::forget(vk::SwapchainKHR const & t_swapchain)
+{
+	// once we hold m_swapchain the thread isn't in a wait, and it can't pick
+	// up one of these again before they're gone
+	auto const swapchain = lock_swapchain();
+	std::lock_guard lock(m_mutex);
+	std::erase_if(m_pending, [&](pending const & t_pending) {
+		return t_pending.swapchain == t_swapchain;
+	});
+}
+
+std::vector<double>
+present_latency::take()
+{
+	std::lock_guard lock(m_mutex);
+	return std::exchange(m_latencies, {});
+}
+
+void
+present_latency::run()
+{
+	constexpr std::uint64_t timeout_ns = 1'000'000;
+	for (;;) {
+		{
+			std::unique_lock lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || !m_pending.empty(); });
+			if (m_stop)
+				return;
+		}
+		// std::mutex isn't fair, without stepping aside the thread could
+		// take the lock again right after every timeout
+		while (m_contending)
+			std::this_thread::yield();
+		std::lock_guard swapchain(m_swapchain);
+		pending         front;
+		{
+			std::lock_guard lock(m_mutex);
+			if (m_pending.empty())
+				continue;
+			front = m_pending.front();
+		}
+		auto const result = m_wait_for_present(
+		    static_cast<VkDevice>(m_dev),
+		    static_cast<VkSwapchainKHR>(front.swapchain),
+		    front.id,
+		    timeout_ns);
+		if (result == VK_TIMEOUT)
+			continue;
+		auto const now = clock::now();
+		std::lock_guard lock(m_mutex);
+		m_pending.pop_front();
+		// an out of date swapchain never displays the frame
+		if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+			m_latencies.push_back(
+			    std::chrono::duration<double, std::milli>(now - front.start).count());
+	}
+}
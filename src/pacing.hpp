@@ -0,0 +1,116 @@
+#ifndef PACING_HPP_INCLUDED
+#define PACING_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+///@brief holds the render loop to a target frame rate
+///
+/// Sleeping alone overshoots by the scheduler's granularity, so the limiter
+/// sleeps until shortly before the frame is due and spins the rest of the
+/// way. Frames are due at fixed intervals, a late frame is made up for by
+/// the next one, unless it's more than a whole interval late.
+///
+class frame_limiter{
+	using clock = std::chrono::steady_clock;
+
+	clock::duration   m_period;
+	clock::duration   m_spin;
+	clock::time_point m_due;
+
+	public:
+	///
+	///@param[in] t_fps frames per second to keep to
+	///@param[in] t_spin how long before the due time to stop sleeping
+	///
+	explicit frame_limiter(
+	    double                    t_fps,
+	    std::chrono::microseconds t_spin = std::chrono::microseconds(1500));
+
+	///
+	///@brief blocks until the next frame is due
+	///
+	void wait();
+};
+
+///
+///@brief measures when presented frames actually reach the display, with
+/// VK_KHR_present_id and VK_KHR_present_wait
+///
+/// A thread waits for the presents in order and records how long after
+/// their start, the event poll of the frame, they were displayed. The wait
+/// needs the swapchain externally synchronized like acquire and present do,
+/// so the render thread takes lock_swapchain() around those. Waits time out
+/// every millisecond and give way to the render thread, so neither it nor
+/// forgetting a swapchain before it's destroyed stalls for long.
+///
+class present_latency{
+	using clock = std::chrono::steady_clock;
+	struct pending{
+		vk::SwapchainKHR  swapchain;
+		std::uint64_t     id;
+		clock::time_point start;
+	};
+
+	vk::Device              m_dev;
+	PFN_vkWaitForPresentKHR m_wait_for_present;
+	std::mutex              m_swapchain;  // host access to the swapchains
+	std::atomic<unsigned>   m_contending {0}; // render thread waits for it
+	std::mutex              m_mutex;   // guards everything below
+	std::condition_variable m_wake;
+	std::deque<pending>     m_pending;
+	std::vector<double>     m_latencies;
+	bool                    m_stop = false;
+	std::thread             m_thread;
+
+	void run();
+
+	public:
+	///
+	///@brief the device extensions the measurement needs
+	///
+	static std::vector<char const *> required_extensions();
+
+	///
+	///@param[in] t_dev device created with the extensions and the presentId
+	/// and presentWait features
+	///
+	explicit present_latency(vk::Device const & t_dev);
+	present_latency(present_latency const &) = delete;
+	present_latency & operator=(present_latency const &) = delete;
+	~present_latency();
+
+	///
+	///@brief locks host access to the swapchains, hold it around acquiring,
+	/// presenting and creating a swapchain from an old one
+	///
+	std::unique_lock<std::mutex> lock_swapchain();
+
+	///
+	///@brief waits for the present with the id, which has to be passed in
+	/// a vk::PresentIdKHR to the present call
+	///
+	void presented(vk::SwapchainKHR const & t_swapchain, std::uint64_t t_id, clock::time_point t_start);
+
+	///
+	///@brief drops the presents to the swapchain that are still waited on,
+	/// call it before the swapchain is destroyed
+	///
+	void forget(vk::SwapchainKHR const & t_swapchain);
+
+	///
+	///@return the latencies recorded since the last call, in milliseconds
+	///
+	std::vector<double> take();
+};
+
+#endif // PACING_HPP_INCLUDED
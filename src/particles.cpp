@@ -0,0 +1,140 @@
+#include "particles.hpp"
+#include <algorithm>
+
+particle_system::particle_system(
+    device_allocator &              t_alloc,
+    vk::Device const &              t_dev,
+    vk::PipelineCache const &       t_cache,
+    std::span<std::uint32_t const> t_families,
+    std::uint32_t                   t_slots,
+    std::uint32_t                   t_count)
+    : m_count(std::max(t_count, 1u))
+{
+	// the previous state and the one written
+	std::array<vk::DescriptorSetLayoutBinding, 2> bindings;
+	for (std::uint32_t i = 0; i < bindings.size(); ++i)
+		bindings[i] = {
+		    .binding         = i,
+		    .descriptorType  = vk::DescriptorType::eStorageBuffer,
+		    .descriptorCount = 1,
+		    .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+		};
+	m_set_layout = t_dev.createDescriptorSetLayoutUnique({
+	    .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+	    .pBindings    = bindings.data(),
+	});
+	vk::PushConstantRange const constants {
+	    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+	    .offset     = 0,
+	    .size       = sizeof(particle_constants),
+	};
+	m_layout = t_dev.createPipelineLayoutUnique({
+	    .setLayoutCount         = 1,
+	    .pSetLayouts            = &*m_set_layout,
+	    .pushConstantRangeCount = 1,
+	    .pPushConstantRanges    = &constants,
+	});
+	m_pipeline = make_compute_pipeline(t_dev, t_cache, "particle_sim", *m_layout);
+
+	vk::DescriptorPoolSize const pool_size {
+	    .type            = vk::DescriptorType::eStorageBuffer,
+	    .descriptorCount = t_slots * static_cast<std::uint32_t>(bindings.size()),
+	};
+	m_descriptor_pool = t_dev.createDescriptorPoolUnique({
+	    .maxSets       = t_slots,
+	    .poolSizeCount = 1,
+	    .pPoolSizes    = &pool_size,
+	});
+	std::vector<vk::DescriptorSetLayout> const layouts(t_slots, *m_set_layout);
+	auto const sets = t_dev.allocateDescriptorSets({
+	    .descriptorPool     = *m_descriptor_pool,
+	    .descriptorSetCount = t_slots,
+	    .pSetLayouts        = layouts.data(),
+	});
+
+	auto const concurrent = t_families.size() > 1;
+	m_slots.reserve(t_slots);
+	for (auto const & set : sets) {
+		slot_buffer slot {
+		    .buffer = t_dev.createBufferUnique({
+		        .size  = m_count * sizeof(particle),
+		        .usage = vk::BufferUsageFlagBits::eStorageBuffer |
+		                 vk::BufferUsageFlagBits::eVertexBuffer,
+		        .sharingMode = concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+		        .queueFamilyIndexCount = concurrent ? static_cast<std::uint32_t>(t_families.size()) : 0u,
+		        .pQueueFamilyIndices   = concurrent ? t_families.data() : nullptr,
+		    }),
+		    .memory = {},
+		    .set    = set,
+		};
+		slot.memory = t_alloc.bind(*slot.buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		m_slots.push_back(std::move(slot));
+	}
+	// the buffers never change, neither do the sets
+	for (std::uint32_t i = 0; i < t_slots; ++i) {
+		std::array<vk::DescriptorBufferInfo, 2> const infos {{
+		    {.buffer = *m_slots[(i + t_slots - 1) % t_slots].buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		    {.buffer = *m_slots[i].buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		}};
+		std::array<vk::WriteDescriptorSet, 2> writes;
+		for (std::uint32_t b = 0; b < writes.size(); ++b)
+			writes[b] = {
+			    .dstSet          = m_slots[i].set,
+			    .dstBinding      = b,
+			    .dstArrayElement = 0,
+			    .descriptorCount = 1,
+			    .descriptorType  = vk::DescriptorType::eStorageBuffer,
+			    .pBufferInfo     = &infos[b],
+			};
+		t_dev.updateDescriptorSets(writes, nullptr);
+	}
+}
+
+std::uint32_t
+particle_system::count() const
+{
+	return m_count;
+}
+
+vk::Buffer
+particle_system::buffer(std::uint32_t t_slot) const
+{
+	return *m_slots.at(t_slot).buffer;
+}
+
+void
+particle_system::record(
+    vk::CommandBuffer const &  t_cmd,
+    std::uint32_t              t_slot,
+    particle_constants const & t_constants,
+    bool                       t_on_graphics_queue) const
+{
+	using psf = vk::PipelineStageFlagBits;
+	using af  = vk::AccessFlagBits;
+	// the previous step was written by the previous submission on this queue
+	t_cmd.pipelineBarrier(
+	    psf::eComputeShader,
+	    psf::eComputeShader,
+	    {},
+	    vk::MemoryBarrier {
+	        .srcAccessMask = af::eShaderWrite,
+	        .dstAccessMask = af::eShaderRead,
+	    },
+	    nullptr,
+	    nullptr);
+	t_cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *m_pipeline.pipeline);
+	t_cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_layout, 0, m_slots.at(t_slot).set, nullptr);
+	t_cmd.pushConstants<particle_constants>(*m_layout, vk::ShaderStageFlagBits::eCompute, 0, t_constants);
+	t_cmd.dispatch((m_count + 255) / 256, 1, 1);
+	if (t_on_graphics_queue)
+		t_cmd.pipelineBarrier(
+		    psf::eComputeShader,
+		    psf::eVertexInput,
+		    {},
+		    vk::MemoryBarrier {
+		        .srcAccessMask = af::eShaderWrite,
+		        .dstAccessMask = af::eVertexAttributeRead,
+		    },
+		    nullptr,
+		    nullptr);
+}
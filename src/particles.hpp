@@ -0,0 +1,108 @@
+#ifndef PARTICLES_HPP_INCLUDED
+#define PARTICLES_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "allocator.hpp"
+#include "shaders.hpp"
+
+///
+///@brief a simulated particle, also the vertex layout of the particles
+/// pipeline
+///
+struct particle{
+	std::array<float, 2> position;
+	std::array<float, 2> velocity;
+};
+
+inline constexpr vk::VertexInputBindingDescription particle_binding {
+    .binding   = 0,
+    .stride    = sizeof(particle),
+    .inputRate = vk::VertexInputRate::eVertex,
+};
+
+inline constexpr std::array<vk::VertexInputAttributeDescription, 2> particle_attributes {{
+    {
+        .location = 0,
+        .binding  = 0,
+        .format   = vk::Format::eR32G32Sfloat,
+        .offset   = offsetof(particle, position),
+    },
+    {
+        .location = 1,
+        .binding  = 0,
+        .format   = vk::Format::eR32G32Sfloat,
+        .offset   = offsetof(particle, velocity),
+    },
+}};
+
+///
+///@brief push constants of the simulation shader
+///
+struct particle_constants{
+	float         dt;
+	std::uint32_t count;
+	std::uint32_t steps; ///< integration steps per frame
+	std::uint32_t init;  ///< non zero on the first frame
+};
+
+///
+///@brief a particle simulation run as a compute workload, on its own queue
+/// when there's an async compute family
+///
+/// Every frame slot has its own particle buffer. A frame's simulation reads
+/// the previous slot's buffer and writes its own, which the frame then
+/// draws, so the simulation of the next frame can run while the current
+/// one is still being drawn. The buffers are shared concurrently by the
+/// compute and graphics families, so no ownership transfers are needed.
+///
+class particle_system{
+	struct slot_buffer{
+		vk::UniqueBuffer  buffer;
+		allocation        memory;
+		vk::DescriptorSet set;
+	};
+
+	std::uint32_t                 m_count;
+	vk::UniqueDescriptorSetLayout m_set_layout;
+	vk::UniquePipelineLayout      m_layout;
+	compute_pipeline_t            m_pipeline;
+	vk::UniqueDescriptorPool      m_descriptor_pool;
+	std::vector<slot_buffer>      m_slots;
+
+	public:
+	///
+	///@param[in] t_families the families using the buffers, graphics and
+	/// compute, or just one when they are the same
+	///@param[in] t_slots number of frames in flight
+	///
+	particle_system(
+	    device_allocator &              t_alloc,
+	    vk::Device const &              t_dev,
+	    vk::PipelineCache const &       t_cache,
+	    std::span<std::uint32_t const> t_families,
+	    std::uint32_t                   t_slots,
+	    std::uint32_t                   t_count);
+
+	std::uint32_t count() const;
+	vk::Buffer    buffer(std::uint32_t t_slot) const;
+
+	///
+	///@brief records the slot's simulation step
+	///
+	///@param[in] t_on_graphics_queue the command buffer goes to the graphics
+	/// queue, which then needs a barrier before drawing, the other queue is
+	/// synchronised by the semaphore between the submissions
+	///
+	void record(
+	    vk::CommandBuffer const &  t_cmd,
+	    std::uint32_t              t_slot,
+	    particle_constants const & t_constants,
+	    bool                       t_on_graphics_queue) const;
+};
+
+#endif // PARTICLES_HPP_INCLUDED
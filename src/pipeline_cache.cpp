@@ -0,0 +1,122 @@
+#include "pipeline_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace{
+
+// prepended to the driver's blob, the driver's own header has no driver
+// version and a driver update doesn't necessarily change pipelineCacheUUID
+struct file_header{
+	std::array<char, 4>                     magic;
+	std::uint32_t                           vendor_id;
+	std::uint32_t                           device_id;
+	std::uint32_t                           driver_version;
+	std::array<std::uint8_t, VK_UUID_SIZE>  uuid;
+	std::uint64_t                           data_size;
+};
+
+constexpr std::array<char, 4> magic {'V', 'K', 'P', 'C'};
+
+file_header
+make_header(vk::PhysicalDeviceProperties const & t_props, std::uint64_t t_size)
+{
+	file_header out {
+	    .magic          = magic,
+	    .vendor_id      = t_props.vendorID,
+	    .device_id      = t_props.deviceID,
+	    .driver_version = t_props.driverVersion,
+	    .uuid           = {},
+	    .data_size      = t_size,
+	};
+	std::copy(
+	    t_props.pipelineCacheUUID.begin(),
+	    t_props.pipelineCacheUUID.end(),
+	    out.uuid.begin());
+	return out;
+}
+
+// checks the VkPipelineCacheHeaderVersionOne at the start of the blob
+bool
+valid_driver_header(
+    vk::PhysicalDeviceProperties const & t_props,
+    std::vector<char> const &            t_data)
+{
+	std::uint32_t words[4];
+	if (t_data.size() < sizeof(words) + VK_UUID_SIZE)
+		return false;
+	std::memcpy(words, t_data.data(), sizeof(words));
+	auto const [header_size, version, vendor, device] = words;
+	return header_size >= sizeof(words) + VK_UUID_SIZE &&
+	       version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+	       vendor == t_props.vendorID && device == t_props.deviceID &&
+	       !std::memcmp(
+	           t_data.data() + sizeof(words),
+	           t_props.pipelineCacheUUID.data(),
+	           VK_UUID_SIZE);
+}
+
+} // namespace
+
+load_pipeline_cache_t
+load_pipeline_cache(
+    vk::PhysicalDevice const &    t_phys,
+    vk::Device const &            t_dev,
+    std::filesystem::path const & t_path)
+{
+	auto const        props = t_phys.getProperties();
+	std::vector<char> data;
+	std::error_code   ec;
+	auto const        file_size = std::filesystem::file_size(t_path, ec);
+	if (std::ifstream file(t_path, std::ios::binary);
+	    !ec && file_size >= sizeof(file_header) && file.is_open())
+	{
+		file_header header {};
+		file.read(reinterpret_cast<char *>(&header), sizeof(header));
+		auto const expected =
+		    make_header(props, file_size - sizeof(file_header));
+		if (file && !std::memcmp(&header, &expected, sizeof(header)))
+		{
+			data.resize(header.data_size);
+			file.read(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!file || !valid_driver_header(props, data))
+				data.clear();
+		}
+	}
+	return {
+	    .cache = t_dev.createPipelineCacheUnique({
+	        .initialDataSize = data.size(),
+	        .pInitialData    = data.data(),
+	    }),
+	    .warm = !data.empty(),
+	};
+}
+
+void
+save_pipeline_cache(
+    vk::PhysicalDevice const &    t_phys,
+    vk::Device const &            t_dev,
+    vk::PipelineCache const &     t_cache,
+    std::filesystem::path const & t_path)
+{
+	auto const data   = t_dev.getPipelineCacheData(t_cache);
+	auto const header = make_header(t_phys.getProperties(), data.size());
+	auto       temp   = t_path;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throw std::runtime_error("could not write the pipeline cache");
+		file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+		file.write(
+		    reinterpret_cast<char const *>(data.data()),
+		    static_cast<std::streamsize>(data.size()));
+		if (!file.flush())
+			throw std::runtime_error("could not write the pipeline cache");
+	}
+	// rename replaces the old file atomically
+	std::filesystem::rename(temp, t_path);
+}
@@ -0,0 +1,39 @@
+#ifndef PIPELINE_CACHE_HPP_INCLUDED
+#define PIPELINE_CACHE_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <filesystem>
+
+struct load_pipeline_cache_t{
+	vk::UniquePipelineCache cache;
+	bool                    warm; ///< true if it was seeded from the file
+};
+
+///
+///@brief creates a pipeline cache, seeded from the file if it was written
+/// by the same device and driver
+///
+/// A missing, truncated or foreign file is not an error, the cache just
+/// starts out empty.
+///
+///@param[in] t_path file written by save_pipeline_cache
+///
+load_pipeline_cache_t
+load_pipeline_cache(
+    vk::PhysicalDevice const &    t_phys,
+    vk::Device const &            t_dev,
+    std::filesystem::path const & t_path);
+
+///
+///@brief writes the cache contents to the file, replacing it atomically so
+/// a crash midway never leaves a torn cache behind
+///
+void
+save_pipeline_cache(
+    vk::PhysicalDevice const &    t_phys,
+    vk::Device const &            t_dev,
+    vk::PipelineCache const &     t_cache,
+    std::filesystem::path const & t_path);
+
+#endif // PIPELINE_CACHE_HPP_INCLUDED
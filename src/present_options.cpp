@@ -0,0 +1,81 @@
+#include "present_options.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+constexpr std::array<std::pair<std::string_view, vk::PresentModeKHR>, 4> present_mode_names {{
+    {"mailbox", vk::PresentModeKHR::eMailbox},
+    {"fifo", vk::PresentModeKHR::eFifo},
+    {"fifo-relaxed", vk::PresentModeKHR::eFifoRelaxed},
+    {"immediate", vk::PresentModeKHR::eImmediate},
+}};
+
+constexpr std::array<std::pair<std::string_view, vk::Format>, 5> format_names {{
+    {"bgra8-unorm", vk::Format::eB8G8R8A8Unorm},
+    {"bgra8-srgb", vk::Format::eB8G8R8A8Srgb},
+    {"rgba8-unorm", vk::Format::eR8G8B8A8Unorm},
+    {"rgba8-srgb", vk::Format::eR8G8B8A8Srgb},
+    {"a2b10g10r10-unorm", vk::Format::eA2B10G10R10UnormPack32},
+}};
+
+// looks every comma separated name of t_list up in t_names
+template<class T, std::size_t N>
+std::vector<T>
+parse_list(
+    std::string_view                                     t_option,
+    std::string_view                                     t_list,
+    std::array<std::pair<std::string_view, T>, N> const & t_names)
+{
+	std::vector<T> out;
+	while (!t_list.empty()) {
+		auto const comma = t_list.find(',');
+		auto const name  = t_list.substr(0, comma);
+		auto const it    = std::find_if(t_names.begin(), t_names.end(), [&](auto const & t_entry) {
+			return t_entry.first == name;
+		});
+		if (it == t_names.end())
+			throw std::runtime_error(
+			    "--" + std::string(t_option) + " doesn't know " + std::string(name));
+		out.push_back(it->second);
+		t_list.remove_prefix(comma == t_list.npos ? t_list.size() : comma + 1);
+	}
+	return out;
+}
+
+std::uint32_t
+positive(args const & t_args, std::string_view t_option, std::uint32_t t_default)
+{
+	if (!t_args.named.contains(t_option))
+		return t_default;
+	auto const value = get_named<std::uint32_t>(t_args, t_option);
+	if (!value || !*value)
+		throw std::runtime_error("--" + std::string(t_option) + " takes a positive number");
+	return *value;
+}
+
+} // namespace
+
+present_options
+parse_present_options(args const & t_args)
+{
+	present_options out {
+	    .present_modes    = {vk::PresentModeKHR::eImmediate},
+	    .formats          = {},
+	    .image_count      = positive(t_args, "image-count", 3),
+	    .frames_in_flight = positive(t_args, "frames-in-flight", 2),
+	};
+	if (auto const modes = get_named<std::string_view>(t_args, "present-mode"))
+		out.present_modes = parse_list("present-mode", *modes, present_mode_names);
+	if (auto const formats = get_named<std::string_view>(t_args, "surface-format"))
+		for (auto const format : parse_list("surface-format", *formats, format_names))
+			out.formats.push_back({
+			    .format     = format,
+			    .colorSpace = vk::ColorSpaceKHR::eSrgbNonlinear,
+			});
+	return out;
+}
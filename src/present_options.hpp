@@ -0,0 +1,35 @@
+#ifndef PRESENT_OPTIONS_HPP_INCLUDED
+#define PRESENT_OPTIONS_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+#include "helper.hpp"
+
+///
+///@brief how frames are queued up for presentation, trading latency for
+/// throughput
+///
+struct present_options{
+	std::vector<vk::PresentModeKHR>   present_modes; ///< most preferred first
+	std::vector<vk::SurfaceFormatKHR> formats;       ///< most preferred first
+	std::uint32_t                     image_count;
+	std::uint32_t                     frames_in_flight;
+};
+
+///
+///@brief reads the options from the command line
+///
+/// --present-mode=<list> comma separated priority list of mailbox, fifo,
+/// fifo-relaxed and immediate, --image-count=<n> the swapchain images asked
+/// for, --frames-in-flight=<n> and --surface-format=<list> comma separated
+/// priority list of bgra8-unorm, bgra8-srgb, rgba8-unorm, rgba8-srgb and
+/// a2b10g10r10-unorm. Whatever isn't given keeps its old default.
+///
+///@throws std::runtime_error on a value that isn't understood
+///
+present_options
+parse_present_options(args const & t_args);
+
+#endif // PRESENT_OPTIONS_HPP_INCLUDED
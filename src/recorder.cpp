@@ -0,0 +1,103 @@
+#include "recorder.hpp"
+#include <algorithm>
+#include "trace.hpp"
+
+command_recorder::command_recorder(
+    vk::Device const & t_dev,
+    std::uint32_t      t_family,
+    std::uint32_t      t_frames_in_flight,
+    std::size_t        t_threads,
+    std::size_t        t_min_slice)
+    : m_dev(t_dev)
+    , m_threads(t_threads)
+    , m_min_slice(std::max<std::size_t>(t_min_slice, 1))
+{
+	auto const make_pool = [&] {
+		return m_dev.createCommandPoolUnique({
+		    .flags            = vk::CommandPoolCreateFlagBits::eTransient,
+		    .queueFamilyIndex = t_family,
+		});
+	};
+	m_frames.reserve(t_frames_in_flight);
+	for (std::uint32_t i = 0; i < t_frames_in_flight; ++i) {
+		frame f {.pool = make_pool(), .primary = {}, .workers = {}};
+		f.primary = std::move(m_dev.allocateCommandBuffersUnique({
+		    .commandPool        = *f.pool,
+		    .level              = vk::CommandBufferLevel::ePrimary,
+		    .commandBufferCount = 1,
+		})[0]);
+		f.workers.reserve(m_threads.size());
+		for (std::size_t w = 0; w < m_threads.size(); ++w)
+			f.workers.push_back({.pool = make_pool(), .secondaries = {}, .used = 0});
+		m_frames.push_back(std::move(f));
+	}
+}
+
+std::size_t
+command_recorder::threads() const
+{
+	return m_threads.size();
+}
+
+vk::CommandBuffer
+command_recorder::begin(std::uint32_t t_slot)
+{
+	auto & f = m_frames[t_slot];
+	m_dev.resetCommandPool(*f.pool);
+	for (auto & w : f.workers) {
+		m_dev.resetCommandPool(*w.pool);
+		w.used = 0;
+	}
+	f.primary->begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+	return *f.primary;
+}
+
+void
+command_recorder::record_pass(
+    std::uint32_t                            t_slot,
+    vk::CommandBufferInheritanceInfo const & t_inheritance,
+    std::size_t                              t_count,
+    record_fn const &                        t_record)
+{
+	auto & f = m_frames[t_slot];
+	// small passes aren't worth handing to many threads
+	auto const used = std::clamp<std::size_t>(
+	    (t_count + m_min_slice - 1) / m_min_slice, 1, f.workers.size());
+	auto const slice = (t_count + used - 1) / used;
+	std::function<void(std::size_t)> const record_slice = [&](std::size_t t_worker) {
+		if (t_worker >= used)
+			return;
+		trace_scope const scope("record slice");
+		auto const first = std::min(t_count, t_worker * slice);
+		auto const count = std::min(t_count - first, slice);
+		// secondaries are allocated on first use and kept, the pool reset
+		// recycles them, every worker only touches its own pool
+		auto & worker = f.workers[t_worker];
+		if (worker.used == worker.secondaries.size())
+			worker.secondaries.push_back(std::move(m_dev.allocateCommandBuffersUnique({
+			    .commandPool        = *worker.pool,
+			    .level              = vk::CommandBufferLevel::eSecondary,
+			    .commandBufferCount = 1,
+			})[0]));
+		auto const & cmd = *worker.secondaries[worker.used++];
+		cmd.begin({
+		    .flags            = vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+		                        vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+		    .pInheritanceInfo = &t_inheritance,
+		});
+		if (count)
+			t_record(cmd, first, count);
+		cmd.end();
+	};
+	// a single slice is recorded right here with the first worker's pool,
+	// the workers sleep through it
+	if (used == 1)
+		record_slice(0);
+	else
+		m_threads.run(record_slice);
+	std::vector<vk::CommandBuffer> secondaries;
+	secondaries.reserve(used);
+	for (std::size_t w = 0; w < used; ++w)
+		secondaries.push_back(*f.workers[w].secondaries[f.workers[w].used - 1]);
+	f.primary->executeCommands(secondaries);
+}
@@ -0,0 +1,82 @@
+#ifndef RECORDER_HPP_INCLUDED
+#define RECORDER_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "thread_pool.hpp"
+
+///
+///@brief records every frame's commands anew, splitting the draws of a pass
+/// across worker threads
+///
+/// Command pools aren't thread safe, so every worker owns a pool per frame
+/// slot and records a secondary command buffer per pass with its slice of
+/// the draws. The primary buffer of the slot runs them in order. A slot's pools
+/// are reset wholesale once its previous frame has retired instead of
+/// freeing buffers one by one.
+///
+class command_recorder{
+	struct worker_frame{
+		vk::UniqueCommandPool                pool;
+		std::vector<vk::UniqueCommandBuffer> secondaries;
+		std::size_t                          used; // by the passes so far
+	};
+	struct frame{
+		vk::UniqueCommandPool     pool;
+		vk::UniqueCommandBuffer   primary;
+		std::vector<worker_frame> workers;
+	};
+
+	vk::Device         m_dev;
+	thread_pool        m_threads;
+	std::size_t        m_min_slice;
+	std::vector<frame> m_frames;
+
+	public:
+	///
+	///@brief records the draws [first, first + count) into the buffer
+	///
+	using record_fn = std::function<void(
+	    vk::CommandBuffer const & t_cmd, std::size_t t_first, std::size_t t_count)>;
+
+	///
+	///@param[in] t_family queue family the buffers are submitted to
+	///@param[in] t_threads number of recording threads
+	///@param[in] t_min_slice fewest draws worth handing to a thread of its own
+	///
+	command_recorder(
+	    vk::Device const & t_dev,
+	    std::uint32_t      t_family,
+	    std::uint32_t      t_frames_in_flight,
+	    std::size_t        t_threads,
+	    std::size_t        t_min_slice = 256);
+
+	std::size_t threads() const;
+
+	///
+	///@brief resets the slot's pools and begins its primary buffer
+	///
+	///The slot's previous submission must have retired.
+	///
+	vk::CommandBuffer begin(std::uint32_t t_slot);
+
+	///
+	///@brief records the draws into secondary buffers in parallel and
+	/// executes them from the slot's primary buffer
+	///
+	///The primary buffer must be inside a render pass begun with
+	///vk::SubpassContents::eSecondaryCommandBuffers. Secondary buffers
+	///inherit no state, t_record has to bind everything it uses.
+	///
+	void record_pass(
+	    std::uint32_t                            t_slot,
+	    vk::CommandBufferInheritanceInfo const & t_inheritance,
+	    std::size_t                              t_count,
+	    record_fn const &                        t_record);
+};
+
+#endif // RECORDER_HPP_INCLUDED
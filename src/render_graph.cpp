@@ -0,0 +1,419 @@
+#include "render_graph.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+using psf = vk::PipelineStageFlagBits;
+using af  = vk::AccessFlagBits;
+
+///
+///@brief how a pass uses an attachment
+///
+struct attachment_use{
+	vk::ImageLayout        layout;
+	vk::PipelineStageFlags stages;
+	vk::AccessFlags        access;
+	vk::AccessFlags        writes;
+	vk::ImageUsageFlags    usage;
+};
+
+std::optional<attachment_use>
+use_of(graph_pass_info const & t_pass, graph_resource t_resource)
+{
+	auto const in = [&](std::vector<graph_resource> const & t_list) {
+		return std::find(t_list.begin(), t_list.end(), t_resource) != t_list.end();
+	};
+	if (t_pass.depth == t_resource)
+		return attachment_use {
+		    .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+		    .stages = psf::eEarlyFragmentTests | psf::eLateFragmentTests,
+		    .access = af::eDepthStencilAttachmentRead | af::eDepthStencilAttachmentWrite,
+		    .writes = af::eDepthStencilAttachmentWrite,
+		    .usage  = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+		};
+	if (in(t_pass.colors))
+		return attachment_use {
+		    .layout = vk::ImageLayout::eColorAttachmentOptimal,
+		    .stages = psf::eColorAttachmentOutput,
+		    .access = af::eColorAttachmentWrite,
+		    .writes = af::eColorAttachmentWrite,
+		    .usage  = vk::ImageUsageFlagBits::eColorAttachment,
+		};
+	if (in(t_pass.inputs))
+		return attachment_use {
+		    .layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+		    .stages = psf::eFragmentShader,
+		    .access = af::eInputAttachmentRead,
+		    .writes = {},
+		    .usage  = vk::ImageUsageFlagBits::eInputAttachment,
+		};
+	return std::nullopt;
+}
+
+vk::PipelineStageFlags const attachment_stages = psf::eEarlyFragmentTests |
+                                                 psf::eLateFragmentTests |
+                                                 psf::eFragmentShader |
+                                                 psf::eColorAttachmentOutput;
+vk::AccessFlags const attachment_writes = af::eColorAttachmentWrite | af::eDepthStencilAttachmentWrite;
+
+} // namespace
+
+graph_resource
+render_graph::import_image(
+    std::string                   t_name,
+    vk::Format                    t_format,
+    vk::ImageLayout               t_initial_layout,
+    vk::ImageLayout               t_final_layout,
+    std::optional<vk::ClearValue> t_clear)
+{
+	auto const slot = std::count_if(m_resources.begin(), m_resources.end(), [](auto const & r) {
+		return r.imported;
+	});
+	m_resources.push_back({
+	    .name           = std::move(t_name),
+	    .format         = t_format,
+	    .aspect         = vk::ImageAspectFlagBits::eColor,
+	    .imported       = true,
+	    .initial_layout = t_initial_layout,
+	    .final_layout   = t_final_layout,
+	    .clear          = t_clear,
+	    .slot           = static_cast<std::uint32_t>(slot),
+	});
+	return static_cast<graph_resource>(m_resources.size() - 1);
+}
+
+graph_resource
+render_graph::transient_image(
+    std::string                   t_name,
+    vk::Format                    t_format,
+    vk::ImageAspectFlags          t_aspect,
+    std::optional<vk::ClearValue> t_clear)
+{
+	auto const slot = std::count_if(m_resources.begin(), m_resources.end(), [](auto const & r) {
+		return !r.imported;
+	});
+	m_resources.push_back({
+	    .name           = std::move(t_name),
+	    .format         = t_format,
+	    .aspect         = t_aspect,
+	    .imported       = false,
+	    .initial_layout = vk::ImageLayout::eUndefined,
+	    .final_layout   = vk::ImageLayout::eUndefined,
+	    .clear          = t_clear,
+	    .slot           = static_cast<std::uint32_t>(slot),
+	});
+	return static_cast<graph_resource>(m_resources.size() - 1);
+}
+
+graph_pass
+render_graph::add_pass(graph_pass_info t_pass)
+{
+	if (m_render_pass)
+		throw std::logic_error("render graph is already compiled");
+	m_passes.push_back(std::move(t_pass));
+	return static_cast<graph_pass>(m_passes.size() - 1);
+}
+
+void
+render_graph::add_dependency(vk::SubpassDependency const & t_dependency)
+{
+	auto const it = std::find_if(m_dependencies.begin(), m_dependencies.end(), [&](auto const & d) {
+		return d.srcSubpass == t_dependency.srcSubpass && d.dstSubpass == t_dependency.dstSubpass;
+	});
+	if (it == m_dependencies.end()) {
+		m_dependencies.push_back(t_dependency);
+		return;
+	}
+	it->srcStageMask    |= t_dependency.srcStageMask;
+	it->dstStageMask    |= t_dependency.dstStageMask;
+	it->srcAccessMask   |= t_dependency.srcAccessMask;
+	it->dstAccessMask   |= t_dependency.dstAccessMask;
+	it->dependencyFlags &= t_dependency.dependencyFlags;
+}
+
+void
+render_graph::alias_transients()
+{
+	std::vector<graph_resource> transients;
+	for (graph_resource i = 0; i < m_resources.size(); ++i)
+		if (!m_resources[i].imported)
+			transients.push_back(i);
+	std::sort(transients.begin(), transients.end(), [&](auto a, auto b) {
+		return *m_resources[a].first < *m_resources[b].first;
+	});
+	// the latest member of every group, a transient joins the first group
+	// whose latest member is done before it starts. Only images of the same
+	// format share, their memory requirements are then the same as well
+	std::vector<graph_resource> latest;
+	for (auto const i : transients) {
+		auto &     r  = m_resources[i];
+		auto const it = std::find_if(latest.begin(), latest.end(), [&](auto l) {
+			return m_resources[l].format == r.format && m_resources[l].last < *r.first;
+		});
+		if (it == latest.end()) {
+			r.alias = static_cast<std::uint32_t>(latest.size());
+			latest.push_back(i);
+			continue;
+		}
+		auto const & previous = m_resources[*it];
+		r.alias = previous.alias;
+		// the memory changes hands between the two passes
+		auto const before = *use_of(m_passes[previous.last], *it);
+		auto const after  = *use_of(m_passes[*r.first], i);
+		add_dependency({
+		    .srcSubpass      = previous.last,
+		    .dstSubpass      = *r.first,
+		    .srcStageMask    = before.stages,
+		    .dstStageMask    = after.stages,
+		    .srcAccessMask   = before.writes,
+		    .dstAccessMask   = after.access,
+		    .dependencyFlags = vk::DependencyFlagBits::eByRegion,
+		});
+		m_attachments[*it].flags |= vk::AttachmentDescriptionFlagBits::eMayAlias;
+		m_attachments[i].flags   |= vk::AttachmentDescriptionFlagBits::eMayAlias;
+		*it = i;
+	}
+	m_alias_groups = static_cast<std::uint32_t>(latest.size());
+}
+
+void
+render_graph::compile(vk::Device const & t_dev)
+{
+	if (m_render_pass)
+		throw std::logic_error("render graph is already compiled");
+	m_attachments.clear();
+	m_dependencies.clear();
+
+	for (graph_resource i = 0; i < m_resources.size(); ++i) {
+		auto &                        r = m_resources[i];
+		std::optional<attachment_use> previous;
+		for (graph_pass p = 0; p < m_passes.size(); ++p) {
+			if (m_passes[p].depth == i && r.aspect == vk::ImageAspectFlagBits::eColor)
+				throw std::runtime_error(
+				    "render graph pass " + m_passes[p].name + " uses " + r.name + " as depth");
+			auto const u = use_of(m_passes[p], i);
+			if (!u)
+				continue;
+			if (!r.first) {
+				auto const loaded = r.clear || (r.imported && r.initial_layout != vk::ImageLayout::eUndefined);
+				if (!u->writes && !loaded)
+					throw std::runtime_error(
+					    "render graph pass " + m_passes[p].name + " reads " + r.name +
+					    " before anything wrote it");
+				// orders the previous frame's use of the image before this
+				// one. The frames share the transient images, and an alias
+				// group may have ended the previous frame in any stage
+				add_dependency({
+				    .srcSubpass    = VK_SUBPASS_EXTERNAL,
+				    .dstSubpass    = p,
+				    .srcStageMask  = r.imported ? u->stages : attachment_stages,
+				    .dstStageMask  = u->stages,
+				    .srcAccessMask = r.imported ? u->writes : attachment_writes,
+				    .dstAccessMask = u->access,
+				});
+			} else if (previous->writes || u->writes) {
+				add_dependency({
+				    .srcSubpass      = r.last,
+				    .dstSubpass      = p,
+				    .srcStageMask    = previous->stages,
+				    .dstStageMask    = u->stages,
+				    .srcAccessMask   = previous->writes,
+				    .dstAccessMask   = u->access,
+				    .dependencyFlags = vk::DependencyFlagBits::eByRegion,
+				});
+			}
+			if (!r.first)
+				r.first = p;
+			r.last = p;
+			r.usage |= u->usage;
+			previous = u;
+		}
+		if (!r.first)
+			throw std::runtime_error("render graph attachment " + r.name + " is never used");
+		if (!r.imported)
+			r.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+
+		auto const load =
+		    r.clear                                                         ? vk::AttachmentLoadOp::eClear
+		    : r.imported && r.initial_layout != vk::ImageLayout::eUndefined ? vk::AttachmentLoadOp::eLoad
+		                                                                    : vk::AttachmentLoadOp::eDontCare;
+		// transient contents die with the render pass, on a tiled gpu they
+		// never leave the tile memory
+		auto const store   = r.imported ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+		auto const stencil = bool(r.aspect & vk::ImageAspectFlagBits::eStencil);
+		m_attachments.push_back({
+		    .format         = r.format,
+		    .samples        = vk::SampleCountFlagBits::e1,
+		    .loadOp         = load,
+		    .storeOp        = store,
+		    .stencilLoadOp  = stencil ? load : vk::AttachmentLoadOp::eDontCare,
+		    .stencilStoreOp = stencil ? store : vk::AttachmentStoreOp::eDontCare,
+		    .initialLayout  = load == vk::AttachmentLoadOp::eLoad ? r.initial_layout : vk::ImageLayout::eUndefined,
+		    .finalLayout    = r.imported ? r.final_layout : previous->layout,
+		});
+	}
+	alias_transients();
+
+	// the references have to stay put until the render pass is created
+	std::vector<std::vector<vk::AttachmentReference>> colors(m_passes.size());
+	std::vector<std::vector<vk::AttachmentReference>> inputs(m_passes.size());
+	std::vector<vk::AttachmentReference>              depths(m_passes.size());
+	std::vector<vk::SubpassDescription>               subpasses;
+	subpasses.reserve(m_passes.size());
+	for (graph_pass p = 0; p < m_passes.size(); ++p) {
+		auto const & pass = m_passes[p];
+		for (auto const r : pass.colors)
+			colors[p].push_back({.attachment = r, .layout = use_of(pass, r)->layout});
+		for (auto const r : pass.inputs)
+			inputs[p].push_back({.attachment = r, .layout = use_of(pass, r)->layout});
+		if (pass.depth)
+			depths[p] = {.attachment = *pass.depth, .layout = use_of(pass, *pass.depth)->layout};
+		subpasses.push_back({
+		    .pipelineBindPoint       = vk::PipelineBindPoint::eGraphics,
+		    .inputAttachmentCount    = static_cast<std::uint32_t>(inputs[p].size()),
+		    .pInputAttachments       = inputs[p].data(),
+		    .colorAttachmentCount    = static_cast<std::uint32_t>(colors[p].size()),
+		    .pColorAttachments       = colors[p].data(),
+		    .pDepthStencilAttachment = pass.depth ? &depths[p] : nullptr,
+		});
+	}
+	m_render_pass = t_dev.createRenderPassUnique({
+	    .attachmentCount = static_cast<std::uint32_t>(m_attachments.size()),
+	    .pAttachments    = m_attachments.data(),
+	    .subpassCount    = static_cast<std::uint32_t>(subpasses.size()),
+	    .pSubpasses      = subpasses.data(),
+	    .dependencyCount = static_cast<std::uint32_t>(m_dependencies.size()),
+	    .pDependencies   = m_dependencies.data(),
+	});
+}
+
+vk::RenderPass
+render_graph::render_pass() const
+{
+	return *m_render_pass;
+}
+
+std::uint32_t
+render_graph::subpass(graph_pass t_pass) const
+{
+	return t_pass;
+}
+
+std::vector<vk::ClearValue>
+render_graph::clear_values() const
+{
+	std::vector<vk::ClearValue> out;
+	out.reserve(m_resources.size());
+	for (auto const & r : m_resources)
+		out.push_back(r.clear.value_or(vk::ClearValue {}));
+	return out;
+}
+
+graph_images
+render_graph::make_images(
+    device_allocator & t_alloc,
+    vk::Device const & t_dev,
+    vk::Extent2D       t_extent) const
+{
+	graph_images out;
+	std::vector<vk::MemoryRequirements> groups(m_alias_groups, vk::MemoryRequirements {
+	    .size           = 0,
+	    .alignment      = 1,
+	    .memoryTypeBits = ~0u,
+	});
+	std::vector<graph_resource> transients;
+	for (graph_resource i = 0; i < m_resources.size(); ++i) {
+		auto const & r = m_resources[i];
+		if (r.imported)
+			continue;
+		auto image = t_dev.createImageUnique({
+		    .imageType     = vk::ImageType::e2D,
+		    .format        = r.format,
+		    .extent        = {.width = t_extent.width, .height = t_extent.height, .depth = 1},
+		    .mipLevels     = 1,
+		    .arrayLayers   = 1,
+		    .samples       = vk::SampleCountFlagBits::e1,
+		    .tiling        = vk::ImageTiling::eOptimal,
+		    .usage         = r.usage,
+		    .sharingMode   = vk::SharingMode::eExclusive,
+		    .initialLayout = vk::ImageLayout::eUndefined,
+		});
+		auto const requirements = t_dev.getImageMemoryRequirements(*image);
+		auto &     group        = groups[r.alias];
+		group.size           = std::max(group.size, requirements.size);
+		group.alignment      = std::max(group.alignment, requirements.alignment);
+		group.memoryTypeBits &= requirements.memoryTypeBits;
+		out.images.push_back(std::move(image));
+		transients.push_back(i);
+	}
+	out.memory.reserve(groups.size());
+	for (auto const & group : groups)
+		out.memory.push_back(t_alloc.allocate(
+		    group,
+		    resource_kind::optimal,
+		    vk::MemoryPropertyFlagBits::eDeviceLocal,
+		    vk::MemoryPropertyFlagBits::eLazilyAllocated));
+	for (std::size_t t = 0; t < transients.size(); ++t) {
+		auto const & r      = m_resources[transients[t]];
+		auto const & memory = out.memory[r.alias];
+		t_dev.bindImageMemory(*out.images[t], memory.memory(), memory.offset());
+		out.views.push_back(t_dev.createImageViewUnique({
+		    .image    = *out.images[t],
+		    .viewType = vk::ImageViewType::e2D,
+		    .format   = r.format,
+		    .subresourceRange = {
+		        .aspectMask     = r.aspect,
+		        .baseMipLevel   = 0,
+		        .levelCount     = 1,
+		        .baseArrayLayer = 0,
+		        .layerCount     = 1,
+		    },
+		}));
+	}
+	return out;
+}
+
+vk::UniqueFramebuffer
+render_graph::make_framebuffer(
+    vk::Device const &             t_dev,
+    graph_images const &           t_images,
+    std::span<vk::ImageView const> t_imported,
+    vk::Extent2D                   t_extent) const
+{
+	std::vector<vk::ImageView> views;
+	views.reserve(m_resources.size());
+	for (auto const & r : m_resources)
+		views.push_back(r.imported ? t_imported[r.slot] : *t_images.views[r.slot]);
+	return t_dev.createFramebufferUnique({
+	    .renderPass      = *m_render_pass,
+	    .attachmentCount = static_cast<std::uint32_t>(views.size()),
+	    .pAttachments    = views.data(),
+	    .width           = t_extent.width,
+	    .height          = t_extent.height,
+	    .layers          = 1,
+	});
+}
+
+void
+render_graph::print(std::ostream & t_out) const
+{
+	t_out << "render graph: " << m_passes.size() << " passes, " << m_resources.size()
+	      << " attachments, " << m_alias_groups << " transient memory blocks\n";
+	for (std::size_t i = 0; i < m_attachments.size(); ++i) {
+		auto const & r = m_resources[i];
+		auto const & a = m_attachments[i];
+		t_out << "  " << r.name << ": " << vk::to_string(a.format) << ", "
+		      << vk::to_string(a.loadOp) << '/' << vk::to_string(a.storeOp) << ", "
+		      << vk::to_string(a.initialLayout) << " -> " << vk::to_string(a.finalLayout);
+		if (!r.imported)
+			t_out << ", transient in block " << r.alias;
+		t_out << '\n';
+	}
+	auto const name = [&](std::uint32_t t_subpass) {
+		return t_subpass == VK_SUBPASS_EXTERNAL ? std::string("external") : m_passes[t_subpass].name;
+	};
+	for (auto const & d : m_dependencies)
+		t_out << "  " << name(d.srcSubpass) << " -> " << name(d.dstSubpass) << ": "
+		      << vk::to_string(d.srcStageMask) << " -> " << vk::to_string(d.dstStageMask) << '\n';
+}
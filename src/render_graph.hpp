@@ -0,0 +1,152 @@
+#ifndef RENDER_GRAPH_HPP_INCLUDED
+#define RENDER_GRAPH_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "allocator.hpp"
+
+using graph_resource = std::uint32_t;
+using graph_pass     = std::uint32_t;
+
+///
+///@brief the attachments a pass uses, every pass becomes a subpass
+///
+struct graph_pass_info{
+	std::string                   name;
+	std::vector<graph_resource>   colors; ///< written
+	std::vector<graph_resource>   inputs; ///< read, written by earlier passes
+	std::optional<graph_resource> depth;  ///< tested and written
+};
+
+///
+///@brief the transient attachments of a compiled graph at one extent
+///
+/// Shared by every framebuffer of the extent, the incoming dependency of
+/// the render pass orders the frames in flight that reuse them.
+///
+struct graph_images{
+	std::vector<allocation>          memory; // a block per alias group
+	std::vector<vk::UniqueImage>     images;
+	std::vector<vk::UniqueImageView> views; // by transient resource
+};
+
+///
+///@brief passes declare the attachments they read and write, the graph
+/// works out the render pass that runs them
+///
+/// compile() turns the passes into the subpasses of a single render pass,
+/// in the order they were added, and derives from how every attachment is
+/// used
+///  - the load and store ops, a transient attachment is never loaded nor
+///    stored, an imported one only when it has to be
+///  - the layout of every attachment reference and the final layouts
+///  - a subpass dependency wherever a pass uses what an earlier one wrote,
+///    and an incoming one covering the previous frame's writes
+///
+/// Transient attachments whose first and last use don't overlap share
+/// memory, and they prefer lazily allocated memory, which tiled gpus never
+/// back with real memory at all.
+///
+/// Only attachments are tracked, buffers written outside of the render
+/// pass keep their own barriers.
+///
+class render_graph{
+	struct resource{
+		std::string                   name;
+		vk::Format                    format;
+		vk::ImageAspectFlags          aspect;
+		bool                          imported;
+		vk::ImageLayout               initial_layout;
+		vk::ImageLayout               final_layout;
+		std::optional<vk::ClearValue> clear;
+		std::uint32_t                 slot; // among the imported or the transient ones
+		vk::ImageUsageFlags           usage = {};
+		std::optional<graph_pass>     first;
+		graph_pass                    last  = 0;
+		std::uint32_t                 alias = 0; // group, transients only
+	};
+
+	std::vector<resource>                  m_resources;
+	std::vector<graph_pass_info>           m_passes;
+	std::vector<vk::AttachmentDescription> m_attachments;
+	std::vector<vk::SubpassDependency>     m_dependencies;
+	std::uint32_t                          m_alias_groups = 0;
+	vk::UniqueRenderPass                   m_render_pass;
+
+	void alias_transients();
+	void add_dependency(vk::SubpassDependency const & t_dependency);
+
+	public:
+	///
+	///@brief an image that outlives the render pass, the swapchain image
+	///
+	///@param[in] t_initial_layout layout the image is in when the render
+	/// pass begins, undefined when its contents don't matter
+	///@param[in] t_clear clears it at its first use instead of loading it
+	///
+	graph_resource import_image(
+	    std::string                   t_name,
+	    vk::Format                    t_format,
+	    vk::ImageLayout               t_initial_layout,
+	    vk::ImageLayout               t_final_layout,
+	    std::optional<vk::ClearValue> t_clear = std::nullopt);
+
+	///
+	///@brief an image that only lives within the render pass, the graph
+	/// creates and owns it
+	///
+	graph_resource transient_image(
+	    std::string                   t_name,
+	    vk::Format                    t_format,
+	    vk::ImageAspectFlags          t_aspect,
+	    std::optional<vk::ClearValue> t_clear = std::nullopt);
+
+	graph_pass add_pass(graph_pass_info t_pass);
+
+	///
+	///@brief creates the render pass, passes can't be added afterwards
+	///
+	///@throws std::runtime_error when a pass reads an attachment no earlier
+	/// pass wrote and that isn't loaded either
+	///
+	void compile(vk::Device const & t_dev);
+
+	vk::RenderPass render_pass() const;
+	std::uint32_t  subpass(graph_pass t_pass) const;
+
+	///
+	///@brief clear values by attachment, for beginning the render pass
+	///
+	std::vector<vk::ClearValue> clear_values() const;
+
+	///
+	///@brief creates the transient attachments for the extent
+	///
+	graph_images make_images(
+	    device_allocator & t_alloc,
+	    vk::Device const & t_dev,
+	    vk::Extent2D       t_extent) const;
+
+	///
+	///@param[in] t_imported views of the imported images, in import order
+	///
+	vk::UniqueFramebuffer make_framebuffer(
+	    vk::Device const &             t_dev,
+	    graph_images const &           t_images,
+	    std::span<vk::ImageView const> t_imported,
+	    vk::Extent2D                   t_extent) const;
+
+	///
+	///@brief prints the attachments with their ops and alias groups, and
+	/// the dependencies between the passes
+	///
+	void print(std::ostream & t_out) const;
+};
+
+#endif // RENDER_GRAPH_HPP_INCLUDED
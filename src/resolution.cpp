@@ -0,0 +1,212 @@
+#include "resolution.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+resolution_controller::resolution_controller(double t_budget, float t_min_scale, std::uint32_t t_settle)
+    : m_budget(t_budget)
+    , m_settle(t_settle)
+{
+	auto const first = static_cast<int>(std::ceil(std::clamp(t_min_scale, 0.125f, 1.0f) * 8));
+	for (int eighths = first; eighths <= 8; ++eighths)
+		m_scales.push_back(static_cast<float>(eighths) / 8);
+	// full resolution until the frame times say otherwise
+	m_step = m_scales.size() - 1;
+}
+
+std::span<float const>
+resolution_controller::scales() const
+{
+	return m_scales;
+}
+
+std::size_t
+resolution_controller::step() const
+{
+	return m_step;
+}
+
+float
+resolution_controller::scale() const
+{
+	return m_scales[m_step];
+}
+
+std::uint64_t
+resolution_controller::changes() const
+{
+	return m_changes;
+}
+
+void
+resolution_controller::update(double t_frame_time)
+{
+	if (m_wait) {
+		--m_wait;
+		return;
+	}
+	m_smoothed = m_smoothed == 0 ? t_frame_time : m_smoothed + 0.1 * (t_frame_time - m_smoothed);
+	auto next = m_step;
+	if (m_smoothed > m_budget && m_step > 0) {
+		next = m_step - 1;
+	} else if (m_step + 1 < m_scales.size()) {
+		// the cost goes with the area, keep a margin so the scale doesn't
+		// bounce between two steps
+		auto const growth = m_scales[m_step + 1] / m_scales[m_step];
+		if (m_smoothed * growth * growth < m_budget * 0.85)
+			next = m_step + 1;
+	}
+	if (next == m_step)
+		return;
+	m_step     = next;
+	m_smoothed = 0;
+	m_wait     = m_settle;
+	++m_changes;
+}
+
+vk::Extent2D
+scale_extent(vk::Extent2D t_extent, float t_scale)
+{
+	auto const side = [&](std::uint32_t t_side) {
+		return std::max(static_cast<std::uint32_t>(static_cast<float>(t_side) * t_scale), 1u);
+	};
+	return {.width = side(t_extent.width), .height = side(t_extent.height)};
+}
+
+std::vector<resolution_bucket>
+make_resolution_buckets(
+    device_allocator &     t_alloc,
+    vk::Device const &     t_dev,
+    render_graph const &   t_graph,
+    vk::Format             t_format,
+    vk::Extent2D           t_extent,
+    std::span<float const> t_scales,
+    std::uint32_t          t_count)
+{
+	std::vector<resolution_bucket> out;
+	out.reserve(t_scales.size());
+	for (auto const scale : t_scales) {
+		auto const extent = scale_extent(t_extent, scale);
+		resolution_bucket bucket {
+		    .extent      = extent,
+		    .color       = make_offscreen_target(
+		        t_alloc,
+		        t_dev,
+		        t_format,
+		        extent,
+		        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+		        t_count),
+		    .views       = {},
+		    .attachments = t_graph.make_images(t_alloc, t_dev, extent),
+		    .fbos        = {},
+		};
+		for (auto const & image : bucket.color.images) {
+			bucket.views.push_back(t_dev.createImageViewUnique({
+			    .image    = *image,
+			    .viewType = vk::ImageViewType::e2D,
+			    .format   = t_format,
+			    .subresourceRange = {
+			        .aspectMask     = vk::ImageAspectFlagBits::eColor,
+			        .baseMipLevel   = 0,
+			        .levelCount     = 1,
+			        .baseArrayLayer = 0,
+			        .layerCount     = 1,
+			    },
+			}));
+			auto const view = *bucket.views.back();
+			bucket.fbos.push_back(t_graph.make_framebuffer(t_dev, bucket.attachments, {&view, 1}, extent));
+		}
+		out.push_back(std::move(bucket));
+	}
+	return out;
+}
+
+void
+record_upscale(
+    vk::CommandBuffer const & t_cmd,
+    vk::Image const &         t_src,
+    vk::Extent2D              t_src_extent,
+    vk::Image const &         t_dst,
+    vk::Extent2D              t_dst_extent,
+    vk::ImageLayout           t_dst_layout,
+    vk::Filter                t_filter)
+{
+	using psf = vk::PipelineStageFlagBits;
+	using af  = vk::AccessFlagBits;
+	vk::ImageSubresourceRange const range {
+	    .aspectMask     = vk::ImageAspectFlagBits::eColor,
+	    .baseMipLevel   = 0,
+	    .levelCount     = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount     = 1,
+	};
+	// the render pass left the rendered image in the layout already, its
+	// writes only have to be made visible. The presented image is waited
+	// for at the transfer stage and its contents don't matter
+	std::array const before {
+	    vk::ImageMemoryBarrier {
+	        .srcAccessMask       = af::eColorAttachmentWrite,
+	        .dstAccessMask       = af::eTransferRead,
+	        .oldLayout           = vk::ImageLayout::eTransferSrcOptimal,
+	        .newLayout           = vk::ImageLayout::eTransferSrcOptimal,
+	        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .image               = t_src,
+	        .subresourceRange    = range,
+	    },
+	    vk::ImageMemoryBarrier {
+	        .srcAccessMask       = {},
+	        .dstAccessMask       = af::eTransferWrite,
+	        .oldLayout           = vk::ImageLayout::eUndefined,
+	        .newLayout           = vk::ImageLayout::eTransferDstOptimal,
+	        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .image               = t_dst,
+	        .subresourceRange    = range,
+	    },
+	};
+	t_cmd.pipelineBarrier(
+	    psf::eColorAttachmentOutput | psf::eTransfer, psf::eTransfer, {}, nullptr, nullptr, before);
+	vk::ImageSubresourceLayers const layers {
+	    .aspectMask     = vk::ImageAspectFlagBits::eColor,
+	    .mipLevel       = 0,
+	    .baseArrayLayer = 0,
+	    .layerCount     = 1,
+	};
+	auto const corner = [](vk::Extent2D t_extent) {
+		return vk::Offset3D {
+		    .x = static_cast<std::int32_t>(t_extent.width),
+		    .y = static_cast<std::int32_t>(t_extent.height),
+		    .z = 1,
+		};
+	};
+	t_cmd.blitImage(
+	    t_src,
+	    vk::ImageLayout::eTransferSrcOptimal,
+	    t_dst,
+	    vk::ImageLayout::eTransferDstOptimal,
+	    vk::ImageBlit {
+	        .srcSubresource = layers,
+	        .srcOffsets     = std::array {vk::Offset3D {}, corner(t_src_extent)},
+	        .dstSubresource = layers,
+	        .dstOffsets     = std::array {vk::Offset3D {}, corner(t_dst_extent)},
+	    },
+	    t_filter);
+	// up to the transfer stage, so a capture's copy chains after the blit
+	t_cmd.pipelineBarrier(
+	    psf::eTransfer,
+	    psf::eTransfer,
+	    {},
+	    nullptr,
+	    nullptr,
+	    vk::ImageMemoryBarrier {
+	        .srcAccessMask       = af::eTransferWrite,
+	        .dstAccessMask       = {},
+	        .oldLayout           = vk::ImageLayout::eTransferDstOptimal,
+	        .newLayout           = t_dst_layout,
+	        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	        .image               = t_dst,
+	        .subresourceRange    = range,
+	    });
+}
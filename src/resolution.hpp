@@ -0,0 +1,103 @@
+#ifndef RESOLUTION_HPP_INCLUDED
+#define RESOLUTION_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "allocator.hpp"
+#include "offscreen.hpp"
+#include "render_graph.hpp"
+
+///
+///@brief picks the render scale that keeps frames within a time budget
+///
+/// The scales go from the minimum up to 1 in steps of an eighth. Frame times
+/// are smoothed, a frame over the budget drops a step, and a step up is
+/// only taken once the smoothed time scaled by the larger area still leaves
+/// some headroom. After a change the controller waits for the frames still
+/// measured at the old scale to pass.
+///
+class resolution_controller{
+	std::vector<float> m_scales; // ascending
+	double             m_budget;
+	std::uint32_t      m_settle;
+	std::size_t        m_step;
+	double             m_smoothed = 0;
+	std::uint32_t      m_wait     = 0;
+	std::uint64_t      m_changes  = 0;
+
+	public:
+	///
+	///@param[in] t_budget milliseconds a frame may take
+	///@param[in] t_min_scale smallest scale of each side, clamped to
+	/// [1/8, 1]
+	///@param[in] t_settle frames the measurements lag behind, ignored after
+	/// every change
+	///
+	resolution_controller(double t_budget, float t_min_scale, std::uint32_t t_settle);
+
+	std::span<float const> scales() const;
+	std::size_t            step() const; ///< index into scales()
+	float                  scale() const;
+	std::uint64_t          changes() const;
+
+	///
+	///@brief feeds the time of a frame in milliseconds
+	///
+	void update(double t_frame_time);
+};
+
+///
+///@return the extent scaled on both sides, at least a pixel
+///
+vk::Extent2D scale_extent(vk::Extent2D t_extent, float t_scale);
+
+///
+///@brief images to render the scene into at one scale, with the graph's
+/// transient attachments and the framebuffers
+///
+struct resolution_bucket{
+	vk::Extent2D                       extent;
+	offscreen_target                   color;
+	std::vector<vk::UniqueImageView>   views;
+	graph_images                       attachments;
+	std::vector<vk::UniqueFramebuffer> fbos;
+};
+
+///
+///@brief creates a bucket per scale up front, so changing scales never
+/// allocates
+///
+///@param[in] t_count images per bucket, one for each image they're scaled
+/// up to
+///
+std::vector<resolution_bucket> make_resolution_buckets(
+    device_allocator &     t_alloc,
+    vk::Device const &     t_dev,
+    render_graph const &   t_graph,
+    vk::Format             t_format,
+    vk::Extent2D           t_extent,
+    std::span<float const> t_scales,
+    std::uint32_t          t_count);
+
+///
+///@brief records the blit of the rendered image to the presented one
+///
+///@param[in] t_src rendered image, in eTransferSrcOptimal after its render
+/// pass
+///@param[in] t_dst image that's presented, its contents are discarded and
+/// it ends up in t_dst_layout
+///
+void record_upscale(
+    vk::CommandBuffer const & t_cmd,
+    vk::Image const &         t_src,
+    vk::Extent2D              t_src_extent,
+    vk::Image const &         t_dst,
+    vk::Extent2D              t_dst_extent,
+    vk::ImageLayout           t_dst_layout,
+    vk::Filter                t_filter);
+
+#endif // RESOLUTION_HPP_INCLUDED
@@ -0,0 +1,93 @@
+#include "shaders.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+// shader_list.inc is generated by the makefile, it includes one file per
+// shader holding SHADER(identifier, pipeline, file, {spirv words...})
+
+namespace{
+
+#define SHADER(t_name, t_pipeline, t_file, ...) \
+	constexpr std::uint32_t t_name[] = __VA_ARGS__;
+#include "shader_list.inc"
+#undef SHADER
+
+constexpr std::array registry {
+#define SHADER(t_name, t_pipeline, t_file, ...) \
+	embedded_shader { \
+	    .pipeline = t_pipeline, \
+	    .file     = t_file, \
+	    .stage    = shader_stage_from_name(t_file), \
+	    .code     = t_name, \
+	},
+#include "shader_list.inc"
+#undef SHADER
+};
+
+} // namespace
+
+std::span<embedded_shader const>
+embedded_shaders()
+{
+	return registry;
+}
+
+embedded_shader const *
+find_embedded_shader(std::string_view t_pipeline, std::string_view t_file)
+{
+	auto const it = std::find_if(
+	    registry.begin(),
+	    registry.end(),
+	    [&](embedded_shader const & t_s) {
+		    return t_s.pipeline == t_pipeline && t_s.file == t_file;
+	    });
+	return it == registry.end() ? nullptr : &*it;
+}
+
+void
+shader_overrides::set(
+    std::string_view           t_pipeline,
+    std::string_view           t_file,
+    std::vector<std::uint32_t> t_code)
+{
+	m_code[std::string(t_pipeline) + '/' + std::string(t_file)] = std::move(t_code);
+}
+
+std::span<std::uint32_t const>
+shader_overrides::code(embedded_shader const & t_shader) const
+{
+	auto const it = m_code.find(std::string(t_shader.pipeline) + '/' + std::string(t_shader.file));
+	if (it == m_code.end())
+		return t_shader.code;
+	return it->second;
+}
+
+compute_pipeline_t
+make_compute_pipeline(
+    vk::Device const &         t_dev,
+    vk::PipelineCache const &  t_cache,
+    std::string_view           t_pipeline_name,
+    vk::PipelineLayout const & t_layout)
+{
+	auto const * const shader = find_embedded_shader(t_pipeline_name, "main.comp");
+	if (!shader)
+		throw std::runtime_error("no compute shader for the pipeline");
+	auto module = t_dev.createShaderModuleUnique({
+	    .codeSize = shader->code.size_bytes(),
+	    .pCode    = shader->code.data(),
+	});
+	auto pipeline = t_dev.createComputePipelineUnique(
+	    t_cache,
+	    {
+	        .stage =
+	            {
+	                .stage  = vk::ShaderStageFlagBits::eCompute,
+	                .module = *module,
+	                .pName  = "main",
+	            },
+	        .layout = t_layout,
+	    }).value;
+	return {std::move(pipeline), std::move(module)};
+}
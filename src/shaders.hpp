@@ -0,0 +1,97 @@
+#ifndef SHADERS_HPP_INCLUDED
+#define SHADERS_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///
+///@brief a SPIR-V module compiled into the binary by the makefile
+///
+struct embedded_shader{
+	std::string_view               pipeline; ///< directory under shaders/
+	std::string_view               file;     ///< source name, e.g. main.vert
+	vk::ShaderStageFlagBits        stage;
+	std::span<std::uint32_t const> code;
+};
+
+///
+///@brief maps a glslc style file extension to the shader stage
+///
+constexpr vk::ShaderStageFlagBits
+shader_stage_from_name(std::string_view const t_file)
+{
+	using stage = vk::ShaderStageFlagBits;
+	if (t_file.ends_with(".vert"))
+		return stage::eVertex;
+	if (t_file.ends_with(".tesc"))
+		return stage::eTessellationControl;
+	if (t_file.ends_with(".tese"))
+		return stage::eTessellationEvaluation;
+	if (t_file.ends_with(".geom"))
+		return stage::eGeometry;
+	if (t_file.ends_with(".frag"))
+		return stage::eFragment;
+	if (t_file.ends_with(".comp"))
+		return stage::eCompute;
+	throw "unknown shader stage"; // not a constant expression, fails the build
+}
+
+///
+///@brief every shader the binary was built with
+///
+std::span<embedded_shader const> embedded_shaders();
+
+///
+///@brief looks up a single shader of a pipeline
+///
+///@return nullptr if there's no such shader
+///
+embedded_shader const *
+find_embedded_shader(std::string_view t_pipeline, std::string_view t_file);
+
+///
+///@brief shader code loaded at runtime that takes the place of the
+/// embedded code of the same shader
+///
+class shader_overrides{
+	// keyed by "<pipeline>/<file>"
+	std::map<std::string, std::vector<std::uint32_t>, std::less<>> m_code;
+
+	public:
+	void set(
+	    std::string_view           t_pipeline,
+	    std::string_view           t_file,
+	    std::vector<std::uint32_t> t_code);
+
+	///
+	///@return the loaded code of the shader, the embedded one if there's none
+	///
+	std::span<std::uint32_t const> code(embedded_shader const & t_shader) const;
+};
+
+///
+///@brief a pipeline along with the shader modules it was built from
+///
+struct compute_pipeline_t{
+	vk::UniquePipeline     pipeline;
+	vk::UniqueShaderModule module;
+};
+
+///
+///@brief builds a compute pipeline from the pipeline's embedded main.comp
+///
+compute_pipeline_t
+make_compute_pipeline(
+    vk::Device const &         t_dev,
+    vk::PipelineCache const &  t_cache,
+    std::string_view           t_pipeline_name,
+    vk::PipelineLayout const & t_layout);
+
+#endif // SHADERS_HPP_INCLUDED
@@ -0,0 +1,149 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+// nearest rank percentile of already sorted samples
+static double
+percentile(std::vector<double> const & t_sorted, double t_p)
+{
+	auto const rank = static_cast<std::size_t>(
+	    std::ceil(t_p / 100.0 * static_cast<double>(t_sorted.size())));
+	return t_sorted[std::clamp<std::size_t>(rank, 1, t_sorted.size()) - 1];
+}
+
+sample_summary
+summarise(std::vector<double> t_samples)
+{
+	if (t_samples.empty())
+		return {};
+	std::sort(t_samples.begin(), t_samples.end());
+	return {
+	    .count = t_samples.size(),
+	    .min   = t_samples.front(),
+	    .mean  = std::accumulate(t_samples.begin(), t_samples.end(), 0.0) /
+	            static_cast<double>(t_samples.size()),
+	    .p50 = percentile(t_samples, 50),
+	    .p95 = percentile(t_samples, 95),
+	    .p99 = percentile(t_samples, 99),
+	    .max = t_samples.back(),
+	};
+}
+
+std::vector<double>
+interval_overlaps(
+    std::vector<std::pair<double, double>> const & t_intervals,
+    std::vector<std::pair<double, double>>         t_others)
+{
+	std::sort(t_others.begin(), t_others.end());
+	std::vector<double> out;
+	out.reserve(t_intervals.size());
+	for (auto const & [begin, end] : t_intervals)
+	{
+		// the first other interval that could still reach into this one
+		auto it = std::lower_bound(
+		    t_others.begin(),
+		    t_others.end(),
+		    begin,
+		    [](auto const & t_other, double t_begin) {
+			    return t_other.second <= t_begin;
+		    });
+		double overlap = 0;
+		for (; it != t_others.end() && it->first < end; ++it)
+			overlap += std::min(end, it->second) - std::max(begin, it->first);
+		out.push_back(overlap);
+	}
+	return out;
+}
+
+static double
+fps(bench_report const & t_report)
+{
+	return t_report.seconds > 0 ?
+        static_cast<double>(t_report.frames) / t_report.seconds :
+        0;
+}
+
+void
+print_report(std::ostream & t_out, bench_report const & t_report)
+{
+	auto const flags = t_out.flags();
+	t_out << t_report.frames << " frames in " << t_report.seconds << " s, "
+	      << fps(t_report) << " fps\n";
+	t_out << std::left << std::setw(12) << "ms" << std::right;
+	for (auto const * const col : {"min", "mean", "p50", "p95", "p99", "max"})
+		t_out << std::setw(10) << col;
+	t_out << '\n' << std::fixed << std::setprecision(3);
+	for (auto const & [name, s] : t_report.series)
+	{
+		t_out << std::left << std::setw(12) << name << std::right;
+		for (auto const v : {s.min, s.mean, s.p50, s.p95, s.p99, s.max})
+			t_out << std::setw(10) << v;
+		t_out << '\n';
+	}
+	t_out.flags(flags);
+}
+
+static void
+write_report_json(std::ostream & t_out, bench_report const & t_report)
+{
+	t_out << "{\"frames\":" << t_report.frames
+	      << ",\"seconds\":" << t_report.seconds
+	      << ",\"fps\":" << fps(t_report) << ",\"series\":{";
+	bool first = true;
+	for (auto const & [name, s] : t_report.series)
+	{
+		t_out << (first ? "" : ",") << '"' << name << "\":{"
+		      << "\"count\":" << s.count << ",\"min\":" << s.min
+		      << ",\"mean\":" << s.mean << ",\"p50\":" << s.p50
+		      << ",\"p95\":" << s.p95 << ",\"p99\":" << s.p99
+		      << ",\"max\":" << s.max << '}';
+		first = false;
+	}
+	t_out << "}}";
+}
+
+void
+print_report_json(std::ostream & t_out, bench_report const & t_report)
+{
+	write_report_json(t_out, t_report);
+	t_out << '\n';
+}
+
+void
+print_sweep(std::ostream & t_out, sweep_report const & t_sweep)
+{
+	if (t_sweep.steps.empty())
+		return;
+	auto const flags = t_out.flags();
+	// every step has the same series, they make up the columns
+	t_out << std::setw(12) << t_sweep.parameter << std::setw(12) << "fps";
+	for (auto const & [name, s] : t_sweep.steps.front().second.series)
+		t_out << std::setw(14) << (name + " p50");
+	t_out << '\n' << std::fixed << std::setprecision(3);
+	for (auto const & [value, report] : t_sweep.steps)
+	{
+		t_out << std::setw(12) << value << std::setw(12) << fps(report);
+		for (auto const & [name, s] : report.series)
+			t_out << std::setw(14) << s.p50;
+		t_out << '\n';
+	}
+	t_out.flags(flags);
+}
+
+void
+print_sweep_json(std::ostream & t_out, sweep_report const & t_sweep)
+{
+	t_out << "{\"parameter\":\"" << t_sweep.parameter << "\",\"steps\":[";
+	bool first = true;
+	for (auto const & [value, report] : t_sweep.steps)
+	{
+		t_out << (first ? "" : ",") << "{\"" << t_sweep.parameter
+		      << "\":" << value << ",\"report\":";
+		write_report_json(t_out, report);
+		t_out << '}';
+		first = false;
+	}
+	t_out << "]}\n";
+}
@@ -0,0 +1,79 @@
+#ifndef STATS_HPP_INCLUDED
+#define STATS_HPP_INCLUDED
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+///
+///@brief order statistics of a series of samples, all in the sample's unit
+///
+struct sample_summary{
+	std::size_t count;
+	double      min;
+	double      mean;
+	double      p50;
+	double      p95;
+	double      p99;
+	double      max;
+};
+
+///
+///@brief summarises the samples, the samples are taken by value since they
+/// need to be sorted
+///
+///@return a zeroed summary if there's no samples
+///
+sample_summary summarise(std::vector<double> t_samples);
+
+///
+///@brief how much of every interval in t_intervals overlaps with any of
+/// t_others, the intervals of each set must not overlap one another
+///
+///@return one overlap per interval of t_intervals, in their order
+///
+std::vector<double> interval_overlaps(
+    std::vector<std::pair<double, double>> const & t_intervals,
+    std::vector<std::pair<double, double>>         t_others);
+
+///
+///@brief results of a benchmark run, every series is in milliseconds
+///
+struct bench_report{
+	std::uint64_t                                       frames;
+	double                                              seconds;
+	std::vector<std::pair<std::string, sample_summary>> series;
+};
+
+///
+///@brief prints the report as a human readable table
+///
+void print_report(std::ostream & t_out, bench_report const & t_report);
+
+///
+///@brief prints the report as a single JSON object
+///
+void print_report_json(std::ostream & t_out, bench_report const & t_report);
+
+///
+///@brief a benchmark run per value of a swept parameter
+///
+struct sweep_report{
+	std::string                                         parameter;
+	std::vector<std::pair<std::uint64_t, bench_report>> steps;
+};
+
+///
+///@brief prints the fps and the median of every series for each step
+///
+void print_sweep(std::ostream & t_out, sweep_report const & t_sweep);
+
+///
+///@brief prints the sweep as a single JSON object, with the full report of
+/// every step
+///
+void print_sweep_json(std::ostream & t_out, sweep_report const & t_sweep);
+
+#endif // STATS_HPP_INCLUDED
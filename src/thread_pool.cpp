@@ -0,0 +1,70 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <utility>
+
+thread_pool::thread_pool(std::size_t t_threads)
+{
+	t_threads = std::max<std::size_t>(t_threads, 1);
+	m_workers.reserve(t_threads);
+	for (std::size_t i = 0; i < t_threads; ++i)
+		m_workers.emplace_back(&thread_pool::work, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto & worker : m_workers)
+		worker.join();
+}
+
+std::size_t
+thread_pool::size() const
+{
+	return m_workers.size();
+}
+
+void
+thread_pool::work(std::size_t t_index)
+{
+	std::uint64_t seen = 0;
+	for (;;) {
+		std::function<void(std::size_t)> const * job;
+		{
+			std::unique_lock lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+			seen = m_generation;
+			job  = m_job;
+		}
+		std::exception_ptr error;
+		try {
+			(*job)(t_index);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		std::lock_guard lock(m_mutex);
+		if (error && !m_error)
+			m_error = error;
+		if (--m_running == 0)
+			m_done.notify_one();
+	}
+}
+
+void
+thread_pool::run(std::function<void(std::size_t)> const & t_job)
+{
+	std::unique_lock lock(m_mutex);
+	m_job     = &t_job;
+	m_running = m_workers.size();
+	++m_generation;
+	m_wake.notify_all();
+	m_done.wait(lock, [&] { return m_running == 0; });
+	m_job = nullptr;
+	if (auto error = std::exchange(m_error, nullptr))
+		std::rethrow_exception(error);
+}
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_HPP_INCLUDED
+#define THREAD_POOL_HPP_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+///@brief a fixed set of worker threads that all run the same job at once
+///
+/// The workers sleep between jobs, run() wakes every one of them and blocks
+/// until they are all done, so the job can borrow anything from the caller.
+///
+class thread_pool{
+	std::vector<std::thread>                 m_workers;
+	std::mutex                               m_mutex;
+	std::condition_variable                  m_wake;
+	std::condition_variable                  m_done;
+	std::function<void(std::size_t)> const * m_job        = nullptr;
+	std::uint64_t                            m_generation = 0;
+	std::size_t                              m_running    = 0;
+	std::exception_ptr                       m_error;
+	bool                                     m_stop = false;
+
+	void work(std::size_t t_index);
+
+	public:
+	///
+	///@param[in] t_threads number of workers, at least one is started
+	///
+	explicit thread_pool(std::size_t t_threads);
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator=(thread_pool const &) = delete;
+	~thread_pool();
+
+	std::size_t size() const;
+
+	///
+	///@brief runs t_job(worker index) on every worker and waits for all of
+	/// them, rethrowing the first exception one of them threw
+	///
+	void run(std::function<void(std::size_t)> const & t_job);
+};
+
+#endif // THREAD_POOL_HPP_INCLUDED
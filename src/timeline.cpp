@@ -0,0 +1,98 @@
+#include "timeline.hpp"
+#include <limits>
+#include <stdexcept>
+
+queue_timeline::queue_timeline(vk::Device const & t_dev)
+    : m_dev(t_dev)
+{
+	vk::SemaphoreTypeCreateInfo const type {
+	    .semaphoreType = vk::SemaphoreType::eTimeline,
+	    .initialValue  = 0,
+	};
+	m_semaphore = m_dev.createSemaphoreUnique({.pNext = &type});
+}
+
+vk::Semaphore
+queue_timeline::semaphore() const
+{
+	return *m_semaphore;
+}
+
+std::uint64_t
+queue_timeline::reserve()
+{
+	return ++m_last;
+}
+
+std::uint64_t
+queue_timeline::last() const
+{
+	return m_last;
+}
+
+std::uint64_t
+queue_timeline::completed() const
+{
+	return m_dev.getSemaphoreCounterValue(*m_semaphore);
+}
+
+bool
+queue_timeline::reached(std::uint64_t t_value) const
+{
+	return completed() >= t_value;
+}
+
+void
+queue_timeline::wait(std::uint64_t t_value) const
+{
+	auto const semaphore = *m_semaphore;
+	vk::SemaphoreWaitInfo const info {
+	    .semaphoreCount = 1,
+	    .pSemaphores    = &semaphore,
+	    .pValues        = &t_value,
+	};
+	auto const result = m_dev.waitSemaphores(info, std::numeric_limits<std::uint64_t>::max());
+	if (result != vk::Result::eSuccess)
+		throw std::runtime_error(vk::to_string(result));
+}
+
+void
+submit_semaphores::add_wait(
+    vk::Semaphore const &  t_semaphore,
+    vk::PipelineStageFlags t_stage,
+    std::uint64_t          t_value)
+{
+	wait.push_back(t_semaphore);
+	wait_stages.push_back(t_stage);
+	wait_values.push_back(t_value);
+}
+
+void
+submit_semaphores::add_signal(vk::Semaphore const & t_semaphore, std::uint64_t t_value)
+{
+	signal.push_back(t_semaphore);
+	signal_values.push_back(t_value);
+}
+
+void
+submit_semaphores::apply(
+    vk::SubmitInfo &                  t_info,
+    vk::TimelineSemaphoreSubmitInfo & t_values,
+    bool                              t_timeline) const
+{
+	t_info.waitSemaphoreCount   = static_cast<std::uint32_t>(wait.size());
+	t_info.pWaitSemaphores      = wait.data();
+	t_info.pWaitDstStageMask    = wait_stages.data();
+	t_info.signalSemaphoreCount = static_cast<std::uint32_t>(signal.size());
+	t_info.pSignalSemaphores    = signal.data();
+	if (!t_timeline)
+		return;
+	t_values = {
+	    .waitSemaphoreValueCount   = static_cast<std::uint32_t>(wait_values.size()),
+	    .pWaitSemaphoreValues      = wait_values.data(),
+	    .signalSemaphoreValueCount = static_cast<std::uint32_t>(signal_values.size()),
+	    .pSignalSemaphoreValues    = signal_values.data(),
+	};
+	t_values.pNext = t_info.pNext;
+	t_info.pNext   = &t_values;
+}
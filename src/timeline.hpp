@@ -0,0 +1,79 @@
+#ifndef TIMELINE_HPP_INCLUDED
+#define TIMELINE_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+
+///
+///@brief the timeline semaphore of a queue, needs Vulkan 1.2
+///
+/// Every submission to the queue that needs tracking reserves the next
+/// value and signals it, so the values increase in submission order and a
+/// single number tells how far the queue got. Submissions have to be made
+/// from one thread, in the order their values were reserved.
+///
+class queue_timeline{
+	vk::Device          m_dev;
+	vk::UniqueSemaphore m_semaphore;
+	std::uint64_t       m_last = 0;
+
+	public:
+	explicit queue_timeline(vk::Device const & t_dev);
+
+	vk::Semaphore semaphore() const;
+
+	///
+	///@return the value for the next submission to signal
+	///
+	std::uint64_t reserve();
+
+	///
+	///@return the last value reserved
+	///
+	std::uint64_t last() const;
+
+	///
+	///@return the value the queue has reached
+	///
+	std::uint64_t completed() const;
+
+	bool reached(std::uint64_t t_value) const;
+
+	///
+	///@brief blocks until the queue reached the value
+	///
+	void wait(std::uint64_t t_value) const;
+};
+
+///
+///@brief semaphores waited on and signalled by a submission, binary ones
+/// paired with a value of 0, which is ignored
+///
+struct submit_semaphores{
+	std::vector<vk::Semaphore>          wait;
+	std::vector<std::uint64_t>          wait_values;
+	std::vector<vk::PipelineStageFlags> wait_stages;
+	std::vector<vk::Semaphore>          signal;
+	std::vector<std::uint64_t>          signal_values;
+
+	void add_wait(
+	    vk::Semaphore const &  t_semaphore,
+	    vk::PipelineStageFlags t_stage,
+	    std::uint64_t          t_value = 0);
+	void add_signal(vk::Semaphore const & t_semaphore, std::uint64_t t_value = 0);
+
+	///
+	///@brief points the submit info at the semaphores, chaining t_values in
+	/// when any of them is a timeline semaphore
+	///
+	///Both have to outlive the submission call.
+	///
+	void apply(
+	    vk::SubmitInfo &                  t_info,
+	    vk::TimelineSemaphoreSubmitInfo & t_values,
+	    bool                              t_timeline) const;
+};
+
+#endif // TIMELINE_HPP_INCLUDED
@@ -0,0 +1,116 @@
+#include "trace.hpp"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct event{
+	char const * name;
+	std::int64_t start;
+	std::int64_t end;
+};
+
+// a thread's events, only that thread appends to it, the lock is for the
+// session reading them in the end and is never contended before
+struct thread_events{
+	std::uint32_t      tid;
+	std::mutex         mutex;
+	std::vector<event> events;
+};
+
+struct registry{
+	std::mutex                                  mutex;
+	std::vector<std::shared_ptr<thread_events>> threads;
+};
+
+registry &
+get_registry()
+{
+	static registry out;
+	return out;
+}
+
+// the registry keeps the events of threads that are gone
+thread_events &
+this_thread_events()
+{
+	thread_local auto const events = [] {
+		auto &          r = get_registry();
+		std::lock_guard lock(r.mutex);
+		auto            out = std::make_shared<thread_events>();
+		out->tid = static_cast<std::uint32_t>(r.threads.size() + 1);
+		out->events.reserve(1024);
+		r.threads.push_back(out);
+		return out;
+	}();
+	return *events;
+}
+
+void
+write_name(std::ostream & t_out, char const * t_name)
+{
+	t_out << '"';
+	for (auto const * c = t_name; *c; ++c) {
+		if (*c == '"' || *c == '\\')
+			t_out << '\\';
+		t_out << *c;
+	}
+	t_out << '"';
+}
+
+} // namespace
+
+std::int64_t
+trace_detail::now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+void
+trace_detail::record(char const * t_name, std::int64_t t_start, std::int64_t t_end)
+{
+	auto &          events = this_thread_events();
+	std::lock_guard lock(events.mutex);
+	events.events.push_back({.name = t_name, .start = t_start, .end = t_end});
+}
+
+trace_session::trace_session(std::filesystem::path t_path)
+    : m_path(std::move(t_path))
+{
+	trace_detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+trace_session::~trace_session()
+{
+	trace_detail::enabled.store(false, std::memory_order_relaxed);
+	std::ofstream out(m_path);
+	if (!out) {
+		std::clog << "could not write the trace to " << m_path << '\n';
+		return;
+	}
+	// timestamps are in microseconds, the fraction keeps the nanoseconds
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::fixed << std::setprecision(3);
+	bool  first = true;
+	auto & r    = get_registry();
+	std::lock_guard registry_lock(r.mutex);
+	for (auto const & thread : r.threads) {
+		std::lock_guard lock(thread->mutex);
+		for (auto const & e : thread->events) {
+			out << (first ? "\n" : ",\n") << "{\"name\":";
+			write_name(out, e.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->tid
+			    << ",\"ts\":" << static_cast<double>(e.start) / 1000.0
+			    << ",\"dur\":" << static_cast<double>(e.end - e.start) / 1000.0 << '}';
+			first = false;
+		}
+		thread->events.clear();
+	}
+	out << "\n]}\n";
+}
@@ -0,0 +1,67 @@
+#ifndef TRACE_HPP_INCLUDED
+#define TRACE_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+namespace trace_detail {
+
+inline std::atomic<bool> enabled {false};
+
+std::int64_t now_ns();
+void record(char const * t_name, std::int64_t t_start, std::int64_t t_end);
+
+} // namespace trace_detail
+
+///
+///@brief marks the time from its construction to its destruction, or to
+/// end(), as an event of the calling thread
+///
+/// While no trace_session is running a marker costs a relaxed load and a
+/// branch, so markers can stay in release builds. The name must be a string
+/// literal, or otherwise outlive the session.
+///
+class trace_scope{
+	char const * m_name;
+	std::int64_t m_start;
+
+	public:
+	explicit trace_scope(char const * t_name)
+	    : m_name(t_name)
+	    , m_start(
+	          trace_detail::enabled.load(std::memory_order_relaxed) ? trace_detail::now_ns() : -1)
+	{}
+	trace_scope(trace_scope const &) = delete;
+	trace_scope & operator=(trace_scope const &) = delete;
+	~trace_scope() { end(); }
+
+	///
+	///@brief ends the event early, for spans that don't match a scope
+	///
+	void end()
+	{
+		if (m_start >= 0)
+			trace_detail::record(m_name, m_start, trace_detail::now_ns());
+		m_start = -1;
+	}
+};
+
+///
+///@brief records the markers of every thread while it's alive and writes
+/// them to a file in the Chrome trace event format when it goes, which
+/// chrome://tracing and Perfetto open
+///
+/// Only one session may be alive at a time.
+///
+class trace_session{
+	std::filesystem::path m_path;
+
+	public:
+	explicit trace_session(std::filesystem::path t_path);
+	trace_session(trace_session const &) = delete;
+	trace_session & operator=(trace_session const &) = delete;
+	~trace_session();
+};
+
+#endif // TRACE_HPP_INCLUDED
@@ -0,0 +1,106 @@
+#include "uniform_ring.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+vk::DeviceSize
+align_up(vk::DeviceSize t_size, vk::DeviceSize t_alignment)
+{
+	return (t_size + t_alignment - 1) / t_alignment * t_alignment;
+}
+
+} // namespace
+
+uniform_ring::uniform_ring(
+    device_allocator &         t_alloc,
+    vk::PhysicalDevice const & t_phys,
+    vk::Device const &         t_dev,
+    std::uint32_t              t_slots,
+    vk::DeviceSize             t_slot_size,
+    vk::DeviceSize             t_range,
+    vk::ShaderStageFlags       t_stages)
+    : m_alignment(std::max<vk::DeviceSize>(
+          t_phys.getProperties().limits.minUniformBufferOffsetAlignment, 1))
+    , m_slot_size(align_up(std::max(t_slot_size, t_range), m_alignment))
+    , m_range(t_range)
+{
+	m_buffer = t_dev.createBufferUnique({
+	    .size        = m_slot_size * t_slots,
+	    .usage       = vk::BufferUsageFlagBits::eUniformBuffer,
+	    .sharingMode = vk::SharingMode::eExclusive,
+	});
+	// coherent memory spares flushing every push
+	m_memory = t_alloc.bind(
+	    *m_buffer,
+	    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+	    vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	vk::DescriptorSetLayoutBinding const binding {
+	    .binding         = 0,
+	    .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+	    .descriptorCount = 1,
+	    .stageFlags      = t_stages,
+	};
+	m_set_layout = t_dev.createDescriptorSetLayoutUnique({
+	    .bindingCount = 1,
+	    .pBindings    = &binding,
+	});
+	vk::DescriptorPoolSize const pool_size {
+	    .type            = vk::DescriptorType::eUniformBufferDynamic,
+	    .descriptorCount = 1,
+	};
+	m_descriptor_pool = t_dev.createDescriptorPoolUnique({
+	    .maxSets       = 1,
+	    .poolSizeCount = 1,
+	    .pPoolSizes    = &pool_size,
+	});
+	// the dynamic offset picks the data, a single set serves every slot
+	m_set = t_dev.allocateDescriptorSets({
+	    .descriptorPool     = *m_descriptor_pool,
+	    .descriptorSetCount = 1,
+	    .pSetLayouts        = &*m_set_layout,
+	}).front();
+	vk::DescriptorBufferInfo const info {
+	    .buffer = *m_buffer,
+	    .offset = 0,
+	    .range  = m_range,
+	};
+	t_dev.updateDescriptorSets(vk::WriteDescriptorSet {
+	    .dstSet          = m_set,
+	    .dstBinding      = 0,
+	    .dstArrayElement = 0,
+	    .descriptorCount = 1,
+	    .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+	    .pBufferInfo     = &info,
+	}, nullptr);
+}
+
+vk::DescriptorSetLayout
+uniform_ring::set_layout() const
+{
+	return *m_set_layout;
+}
+
+vk::DescriptorSet
+uniform_ring::set() const
+{
+	return m_set;
+}
+
+void
+uniform_ring::begin(std::uint32_t t_slot)
+{
+	m_begin = m_slot_size * t_slot;
+	m_head  = 0;
+}
+
+std::uint32_t
+uniform_ring::reserve(std::size_t t_size)
+{
+	if (t_size > m_range || m_head + m_range > m_slot_size)
+		throw std::length_error("uniform ring slot is full");
+	auto const out = m_begin + m_head;
+	m_head = align_up(m_head + t_size, m_alignment);
+	return static_cast<std::uint32_t>(out);
+}
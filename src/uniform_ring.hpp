@@ -0,0 +1,85 @@
+#ifndef UNIFORM_RING_HPP_INCLUDED
+#define UNIFORM_RING_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "allocator.hpp"
+
+///
+///@brief per frame uniform data, written straight into mapped memory
+///
+/// A single host visible buffer stays mapped for the ring's whole life and
+/// is cut into a region per frame slot. Every push bumps the slot's head
+/// and hands back the dynamic offset to bind the data with, so nothing is
+/// allocated or flushed while a frame is recorded. A slot's region is only
+/// rewritten after begin(), which callers do once the slot's previous frame
+/// has retired.
+///
+class uniform_ring{
+	vk::UniqueBuffer              m_buffer;
+	allocation                    m_memory;
+	vk::UniqueDescriptorSetLayout m_set_layout;
+	vk::UniqueDescriptorPool      m_descriptor_pool;
+	vk::DescriptorSet             m_set;
+	vk::DeviceSize                m_alignment;
+	vk::DeviceSize                m_slot_size;
+	vk::DeviceSize                m_range;
+	vk::DeviceSize                m_begin = 0; // of the current slot's region
+	vk::DeviceSize                m_head  = 0; // relative to m_begin
+
+	std::uint32_t reserve(std::size_t t_size);
+
+	public:
+	///
+	///@param[in] t_slot_size bytes a frame slot may push, rounded up to the
+	/// uniform buffer offset alignment
+	///@param[in] t_range bytes the shaders see from every offset, no push
+	/// may be bigger
+	///@param[in] t_stages stages the single dynamic uniform buffer binding
+	/// of the set is visible to
+	///
+	uniform_ring(
+	    device_allocator &         t_alloc,
+	    vk::PhysicalDevice const & t_phys,
+	    vk::Device const &         t_dev,
+	    std::uint32_t              t_slots,
+	    vk::DeviceSize             t_slot_size,
+	    vk::DeviceSize             t_range,
+	    vk::ShaderStageFlags       t_stages);
+
+	///
+	///@brief set layout with the ring's binding, for pipeline layouts
+	///
+	vk::DescriptorSetLayout set_layout() const;
+
+	///
+	///@brief set to bind with the offsets push returns
+	///
+	vk::DescriptorSet set() const;
+
+	///
+	///@brief starts over at the beginning of the slot's region
+	///
+	void begin(std::uint32_t t_slot);
+
+	///
+	///@brief copies the value into the current slot's region
+	///
+	///@return the dynamic offset of the copy
+	///@throws std::length_error when the region or the range is too small
+	///
+	template<class T>
+	std::uint32_t push(T const & t_value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		auto const offset = reserve(sizeof(T));
+		std::memcpy(m_memory.mapped() + offset, &t_value, sizeof(T));
+		return offset;
+	}
+};
+
+#endif // UNIFORM_RING_HPP_INCLUDED
@@ -0,0 +1,351 @@
+#include "upload.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+vk::DeviceSize
+align_up(vk::DeviceSize t_value, vk::DeviceSize t_alignment)
+{
+	return (t_value + t_alignment - 1) / t_alignment * t_alignment;
+}
+
+} // namespace
+
+staging_ring::staging_ring(
+    device_allocator & t_alloc,
+    vk::Device const & t_dev,
+    vk::DeviceSize     t_size)
+    : m_buffer(t_dev.createBufferUnique({
+          .size        = t_size,
+          .usage       = vk::BufferUsageFlagBits::eTransferSrc,
+          .sharingMode = vk::SharingMode::eExclusive,
+      }))
+    , m_memory(t_alloc.bind(
+          *m_buffer,
+          vk::MemoryPropertyFlagBits::eHostVisible |
+              vk::MemoryPropertyFlagBits::eHostCoherent))
+    , m_size(t_size)
+{
+	if (!m_memory.mapped())
+		throw std::runtime_error("staging memory isn't mapped");
+}
+
+vk::Buffer
+staging_ring::buffer() const
+{
+	return *m_buffer;
+}
+
+vk::DeviceSize
+staging_ring::size() const
+{
+	return m_size;
+}
+
+std::byte *
+staging_ring::data(vk::DeviceSize t_offset) const
+{
+	return m_memory.mapped() + t_offset;
+}
+
+std::optional<vk::DeviceSize>
+staging_ring::allocate(vk::DeviceSize t_size, vk::DeviceSize t_alignment)
+{
+	// the used part wraps around the end of the buffer when the head is
+	// behind the tail, or when they meet and nothing is free
+	bool const wrapped = m_head < m_tail || (m_head == m_tail && m_used);
+	auto const aligned = align_up(m_head, t_alignment);
+	auto const limit   = wrapped ? m_tail : m_size;
+	if (aligned + t_size <= limit) {
+		auto const cost = aligned - m_head + t_size;
+		m_used += cost;
+		m_marked += cost;
+		m_head = aligned + t_size;
+		return aligned;
+	}
+	// skip what's left at the end and start over at the front
+	if (!wrapped && t_size <= m_tail) {
+		auto const cost = m_size - m_head + t_size;
+		m_used += cost;
+		m_marked += cost;
+		m_head = t_size;
+		return 0;
+	}
+	return std::nullopt;
+}
+
+staging_ring::mark_t
+staging_ring::mark()
+{
+	mark_t const out {.end = m_head, .bytes = m_marked};
+	m_marked = 0;
+	return out;
+}
+
+void
+staging_ring::release(mark_t const & t_mark)
+{
+	m_tail = t_mark.end;
+	m_used -= t_mark.bytes;
+	// an empty ring starts over so the whole buffer is contiguous again
+	if (!m_used)
+		m_head = m_tail = 0;
+}
+
+uploader::uploader(
+    device_allocator &    t_alloc,
+    vk::Device const &    t_dev,
+    upload_queues const & t_queues,
+    vk::DeviceSize        t_ring_size)
+    : m_dev(t_dev)
+    , m_queues(t_queues)
+    , m_transfer_pool(t_dev.createCommandPoolUnique({
+          .flags            = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = t_queues.transfer_family,
+      }))
+    , m_graphics_pool(t_dev.createCommandPoolUnique({
+          .flags            = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = t_queues.graphics_family,
+      }))
+    , m_ring(t_alloc, t_dev, t_ring_size)
+{}
+
+uploader::~uploader()
+{
+	// the command buffers and the staging memory can't go while in use
+	for (auto const & b : m_in_flight)
+		finished(b, true);
+}
+
+bool
+uploader::dedicated() const
+{
+	return m_queues.transfer_family != m_queues.graphics_family;
+}
+
+bool
+uploader::timeline() const
+{
+	return m_queues.transfer_timeline && m_queues.graphics_timeline;
+}
+
+bool
+uploader::finished(batch const & t_batch, bool t_block) const
+{
+	if (timeline()) {
+		auto const & queue = t_batch.acquiring ? *m_queues.graphics_timeline
+		                                       : *m_queues.transfer_timeline;
+		auto const value = t_batch.acquiring ? t_batch.acquire_value : t_batch.transfer_value;
+		if (t_block)
+			queue.wait(value);
+		return queue.reached(value);
+	}
+	if (t_block)
+		(void)m_dev.waitForFences(
+		    {*t_batch.fence}, true, std::numeric_limits<std::uint64_t>::max());
+	return m_dev.getFenceStatus(*t_batch.fence) == vk::Result::eSuccess;
+}
+
+void
+uploader::begin_recording()
+{
+	m_recording = std::move(m_dev.allocateCommandBuffersUnique({
+	    .commandPool        = *m_transfer_pool,
+	    .level              = vk::CommandBufferLevel::ePrimary,
+	    .commandBufferCount = 1,
+	})[0]);
+	m_recording->begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+}
+
+void
+uploader::upload(
+    vk::Buffer const &         t_dst,
+    vk::DeviceSize             t_dst_offset,
+    std::span<std::byte const> t_data,
+    vk::AccessFlags            t_dst_access,
+    vk::PipelineStageFlags     t_dst_stage)
+{
+	if (t_data.empty())
+		return;
+	if (!m_recording)
+		begin_recording();
+	// big uploads go in pieces so they never need more than a part of the
+	// ring and can stream through it
+	auto const chunk = std::max<vk::DeviceSize>(m_ring.size() / 4, 1);
+	for (vk::DeviceSize done = 0; done < t_data.size();) {
+		auto const size = std::min<vk::DeviceSize>(chunk, t_data.size() - done);
+		auto offset = m_ring.allocate(size, 16);
+		while (!offset) {
+			// the ring is full, older batches make room as they finish and
+			// when it's all ours the copies so far are sent on their way,
+			// the barrier at the end of the upload covers them as well
+			if (m_in_flight.empty()) {
+				flush();
+				begin_recording();
+			} else {
+				retire_front(true);
+			}
+			offset = m_ring.allocate(size, 16);
+		}
+		std::memcpy(m_ring.data(*offset), t_data.data() + done, size);
+		m_recording->copyBuffer(
+		    m_ring.buffer(),
+		    t_dst,
+		    vk::BufferCopy {
+		        .srcOffset = *offset,
+		        .dstOffset = t_dst_offset + done,
+		        .size      = size,
+		    });
+		done += size;
+	}
+	// with a dedicated transfer family the barrier only releases ownership,
+	// the graphics queue makes the data visible when it acquires it
+	auto const family_src = dedicated() ? m_queues.transfer_family : VK_QUEUE_FAMILY_IGNORED;
+	auto const family_dst = dedicated() ? m_queues.graphics_family : VK_QUEUE_FAMILY_IGNORED;
+	m_releases.push_back({
+	    .srcAccessMask       = vk::AccessFlagBits::eTransferWrite,
+	    .dstAccessMask       = dedicated() ? vk::AccessFlags {} : t_dst_access,
+	    .srcQueueFamilyIndex = family_src,
+	    .dstQueueFamilyIndex = family_dst,
+	    .buffer              = t_dst,
+	    .offset              = t_dst_offset,
+	    .size                = t_data.size(),
+	});
+	if (dedicated())
+		m_acquires.push_back({
+		    .srcAccessMask       = {},
+		    .dstAccessMask       = t_dst_access,
+		    .srcQueueFamilyIndex = family_src,
+		    .dstQueueFamilyIndex = family_dst,
+		    .buffer              = t_dst,
+		    .offset              = t_dst_offset,
+		    .size                = t_data.size(),
+		});
+	m_dst_stages |= t_dst_stage;
+}
+
+std::uint64_t
+uploader::flush()
+{
+	if (!m_recording)
+		return m_next_ticket - 1;
+	using psf = vk::PipelineStageFlagBits;
+	// a batch flushed halfway through an upload has no barrier of its own,
+	// the one ending the upload in the next batch covers its copies
+	if (!m_releases.empty())
+		m_recording->pipelineBarrier(
+		    psf::eTransfer,
+		    dedicated() ? vk::PipelineStageFlags {psf::eBottomOfPipe} : m_dst_stages,
+		    {},
+		    nullptr,
+		    m_releases,
+		    nullptr);
+	m_recording->end();
+
+	batch b {
+	    .transfer_cmd   = std::move(m_recording),
+	    .acquire_cmd    = {},
+	    .released       = {},
+	    .fence          = timeline() ? vk::UniqueFence {} : m_dev.createFenceUnique({}),
+	    .transfer_value = timeline() ? m_queues.transfer_timeline->reserve() : 0,
+	    .acquire_value  = 0,
+	    .ring           = m_ring.mark(),
+	    .ticket         = m_next_ticket++,
+	    .acquiring      = false,
+	};
+	if (!m_acquires.empty()) {
+		if (!timeline())
+			b.released = m_dev.createSemaphoreUnique({});
+		b.acquire_cmd = std::move(m_dev.allocateCommandBuffersUnique({
+		    .commandPool        = *m_graphics_pool,
+		    .level              = vk::CommandBufferLevel::ePrimary,
+		    .commandBufferCount = 1,
+		})[0]);
+		b.acquire_cmd->begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		b.acquire_cmd->pipelineBarrier(
+		    psf::eTopOfPipe, m_dst_stages, {}, nullptr, m_acquires, nullptr);
+		b.acquire_cmd->end();
+	}
+	submit_semaphores semaphores;
+	if (timeline())
+		semaphores.add_signal(m_queues.transfer_timeline->semaphore(), b.transfer_value);
+	else if (b.released)
+		semaphores.add_signal(*b.released);
+	vk::SubmitInfo submit_info {
+	    .commandBufferCount = 1,
+	    .pCommandBuffers    = &*b.transfer_cmd,
+	};
+	vk::TimelineSemaphoreSubmitInfo values;
+	semaphores.apply(submit_info, values, timeline());
+	m_queues.transfer.submit({submit_info}, *b.fence);
+	// on the graphics queue itself, later submissions are ordered after the
+	// barrier already
+	if (!dedicated())
+		m_available = b.ticket;
+	m_releases.clear();
+	m_acquires.clear();
+	m_dst_stages = {};
+	m_in_flight.push_back(std::move(b));
+	return m_in_flight.back().ticket;
+}
+
+bool
+uploader::retire_front(bool t_block)
+{
+	auto & b = m_in_flight.front();
+	if (!finished(b, t_block))
+		return false;
+	if (!b.acquiring)
+		m_ring.release(b.ring);
+	if (b.acquire_cmd && !b.acquiring) {
+		// the copy is done, the acquire waits on a semaphore that's already
+		// signalled so it never stalls the graphics queue
+		submit_semaphores semaphores;
+		if (timeline()) {
+			b.acquire_value = m_queues.graphics_timeline->reserve();
+			semaphores.add_wait(
+			    m_queues.transfer_timeline->semaphore(),
+			    vk::PipelineStageFlagBits::eTopOfPipe,
+			    b.transfer_value);
+			semaphores.add_signal(m_queues.graphics_timeline->semaphore(), b.acquire_value);
+		} else {
+			m_dev.resetFences({*b.fence});
+			semaphores.add_wait(*b.released, vk::PipelineStageFlagBits::eTopOfPipe);
+		}
+		vk::SubmitInfo submit_info {
+		    .commandBufferCount = 1,
+		    .pCommandBuffers    = &*b.acquire_cmd,
+		};
+		vk::TimelineSemaphoreSubmitInfo values;
+		semaphores.apply(submit_info, values, timeline());
+		m_queues.graphics.submit({submit_info}, *b.fence);
+		b.acquiring = true;
+		m_available = b.ticket;
+		return true;
+	}
+	m_in_flight.pop_front();
+	return true;
+}
+
+void
+uploader::poll()
+{
+	while (!m_in_flight.empty() && retire_front(false))
+		;
+}
+
+bool
+uploader::available(std::uint64_t t_ticket) const
+{
+	return t_ticket <= m_available;
+}
+
+void
+uploader::wait(std::uint64_t t_ticket)
+{
+	while (!available(t_ticket) && !m_in_flight.empty())
+		retire_front(true);
+}
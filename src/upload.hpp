@@ -0,0 +1,181 @@
+#ifndef UPLOAD_HPP_INCLUDED
+#define UPLOAD_HPP_INCLUDED
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <vector>
+#include "allocator.hpp"
+#include "timeline.hpp"
+
+///
+///@brief a persistently mapped host visible buffer that's allocated from
+/// front to back and released in the same order, like a ring
+///
+class staging_ring{
+	vk::UniqueBuffer m_buffer;
+	allocation       m_memory;
+	vk::DeviceSize   m_size;
+	vk::DeviceSize   m_head   = 0; // first free byte
+	vk::DeviceSize   m_tail   = 0; // first byte still in use
+	vk::DeviceSize   m_used   = 0; // including padding and skipped ends
+	vk::DeviceSize   m_marked = 0; // used bytes not covered by a mark yet
+
+	public:
+	///
+	///@brief everything allocated between two calls to mark()
+	///
+	struct mark_t{
+		vk::DeviceSize end;
+		vk::DeviceSize bytes;
+	};
+
+	staging_ring(
+	    device_allocator & t_alloc,
+	    vk::Device const & t_dev,
+	    vk::DeviceSize     t_size);
+
+	vk::Buffer     buffer() const;
+	vk::DeviceSize size() const;
+	std::byte *    data(vk::DeviceSize t_offset) const;
+
+	///
+	///@return offset of t_size contiguous bytes, nullopt if they don't fit
+	/// until something is released
+	///
+	std::optional<vk::DeviceSize>
+	allocate(vk::DeviceSize t_size, vk::DeviceSize t_alignment);
+
+	///
+	///@brief closes the group of allocations made since the last mark
+	///
+	mark_t mark();
+
+	///
+	///@brief gives the group back, groups must be released in the order
+	/// they were marked
+	///
+	void release(mark_t const & t_mark);
+};
+
+///
+///@brief the queues uploads go through, both the same when there's no
+/// dedicated transfer family
+///
+/// Completion is tracked on the timelines of the queues when both are set,
+/// the same one when the queues are, and with fences otherwise.
+///
+struct upload_queues{
+	vk::Queue        transfer;
+	std::uint32_t    transfer_family;
+	vk::Queue        graphics;
+	std::uint32_t    graphics_family;
+	queue_timeline * transfer_timeline = nullptr;
+	queue_timeline * graphics_timeline = nullptr;
+};
+
+///
+///@brief streams data into device local buffers through a staging ring
+///
+/// With a dedicated transfer family the copies run on the transfer queue,
+/// concurrently with rendering, and the buffers are handed over to the
+/// graphics family by a release/acquire barrier pair. The acquire is only
+/// submitted to the graphics queue once the copy has finished, so the
+/// graphics queue never waits on an upload in progress. Without one the
+/// copies are submitted to the graphics queue with a plain barrier.
+///
+class uploader{
+	struct batch{
+		vk::UniqueCommandBuffer transfer_cmd;
+		vk::UniqueCommandBuffer acquire_cmd;
+		vk::UniqueSemaphore     released; // without timelines
+		vk::UniqueFence         fence;    // without timelines
+		std::uint64_t           transfer_value;
+		std::uint64_t           acquire_value;
+		staging_ring::mark_t    ring;
+		std::uint64_t           ticket;
+		bool                    acquiring;
+	};
+
+	vk::Device                           m_dev;
+	upload_queues                        m_queues;
+	vk::UniqueCommandPool                m_transfer_pool;
+	vk::UniqueCommandPool                m_graphics_pool;
+	staging_ring                         m_ring;
+	std::deque<batch>                    m_in_flight;
+	vk::UniqueCommandBuffer              m_recording;
+	std::vector<vk::BufferMemoryBarrier> m_releases;
+	std::vector<vk::BufferMemoryBarrier> m_acquires;
+	vk::PipelineStageFlags               m_dst_stages;
+	std::uint64_t                        m_next_ticket = 1;
+	std::uint64_t                        m_available   = 0;
+
+	bool dedicated() const;
+	bool timeline() const;
+	// whether the batch's current submission finished, waiting for it if
+	// t_block is set
+	bool finished(batch const & t_batch, bool t_block) const;
+	void begin_recording();
+	// retires the oldest batch, waiting for it if t_block is set
+	bool retire_front(bool t_block);
+
+	public:
+	///
+	///@param[in] t_ring_size size of the staging ring, uploads bigger than a
+	/// quarter of it are split up
+	///
+	uploader(
+	    device_allocator &    t_alloc,
+	    vk::Device const &    t_dev,
+	    upload_queues const & t_queues,
+	    vk::DeviceSize        t_ring_size);
+	uploader(uploader const &) = delete;
+	uploader & operator=(uploader const &) = delete;
+	~uploader();
+
+	///
+	///@brief records a copy of the data into the buffer
+	///
+	///The region must not be in use by the gpu. The data is copied into the
+	///staging ring right away so it doesn't have to outlive the call.
+	///
+	///@param[in] t_dst_access how the graphics queue accesses the region
+	///@param[in] t_dst_stage stages the graphics queue accesses it in
+	///
+	void upload(
+	    vk::Buffer const &         t_dst,
+	    vk::DeviceSize             t_dst_offset,
+	    std::span<std::byte const> t_data,
+	    vk::AccessFlags            t_dst_access,
+	    vk::PipelineStageFlags     t_dst_stage);
+
+	///
+	///@brief submits everything recorded since the last flush
+	///
+	///@return ticket to check the uploads with
+	///
+	std::uint64_t flush();
+
+	///
+	///@brief hands finished transfers over to the graphics queue and
+	/// recycles their staging memory, never blocks
+	///
+	void poll();
+
+	///
+	///@return true once graphics work submitted from now on sees the data
+	///
+	bool available(std::uint64_t t_ticket) const;
+
+	///
+	///@brief blocks until available(t_ticket), the ticket has to come from
+	/// flush()
+	///
+	void wait(std::uint64_t t_ticket);
+};
+
+#endif // UPLOAD_HPP_INCLUDED